@@ -0,0 +1,268 @@
+/**
+ * @file AdcDma.cpp
+ * @brief Timer triggered, DMA backed voltage/current acquisition engine.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "AdcDma.hpp"
+#include "pinmap.h"
+#include "PeripheralPins.h"
+
+#define FLAG_BLOCK      0x1
+#define BLOCK_TIMEOUT   100ms
+
+AdcDma *AdcDma::instance = nullptr;
+
+/** Map an mbed ADC pin onto its HAL regular channel. */
+static uint32_t adcChannel(PinName pin) {
+    uint32_t function = pinmap_function(pin, PinMap_ADC);
+    return __LL_ADC_DECIMAL_NB_TO_CHANNEL(STM_PIN_CHANNEL(function));
+}
+
+/** TIM6 sits on APB1; its clock is doubled when APB1 is prescaled. */
+static uint32_t tim6Clock(void) {
+    uint32_t clk = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) clk *= 2;
+    return clk;
+}
+
+AdcDma::AdcDma(PinName voltagePin, PinName currentPin) : AdcDma(&voltagePin, &currentPin, 1) {}
+
+AdcDma::AdcDma(const PinName *voltagePins, const PinName *currentPins, uint8_t channels) :
+    voltagePins(),
+    currentPins(),
+    channels(channels == 0 ? 1 : channels > MAX_CHANNELS ? MAX_CHANNELS : channels),
+    hadc(),
+    hdma(),
+    htim(),
+    buffer(),
+    blockPeriodUs(0),
+    running(false),
+    produced(0),
+    lastHalf(0),
+    consumed(0),
+    overruns(0) {
+    for (uint8_t c = 0; c < this->channels; ++c) {
+        this->voltagePins[c] = voltagePins[c];
+        this->currentPins[c] = currentPins[c];
+    }
+}
+
+/** Hardware oversampling configuration for each power of two ratio. */
+static const uint32_t OVERSAMPLING_RATIOS[] = {
+    ADC_OVERSAMPLING_RATIO_2, ADC_OVERSAMPLING_RATIO_4, ADC_OVERSAMPLING_RATIO_8,
+    ADC_OVERSAMPLING_RATIO_16, ADC_OVERSAMPLING_RATIO_32, ADC_OVERSAMPLING_RATIO_64,
+    ADC_OVERSAMPLING_RATIO_128, ADC_OVERSAMPLING_RATIO_256
+};
+/** Regular sequence ranks, a voltage then a current rank per channel. */
+static const uint32_t REGULAR_RANKS[2 * AdcDma::MAX_CHANNELS] = {
+    ADC_REGULAR_RANK_1, ADC_REGULAR_RANK_2, ADC_REGULAR_RANK_3, ADC_REGULAR_RANK_4
+};
+/** Right shifts keeping the oversampled sum at Q12.4 or coarser. */
+static const uint32_t OVERSAMPLING_SHIFTS[] = {
+    ADC_RIGHTBITSHIFT_NONE, ADC_RIGHTBITSHIFT_NONE, ADC_RIGHTBITSHIFT_NONE,
+    ADC_RIGHTBITSHIFT_NONE, ADC_RIGHTBITSHIFT_1, ADC_RIGHTBITSHIFT_2,
+    ADC_RIGHTBITSHIFT_3, ADC_RIGHTBITSHIFT_4
+};
+
+bool AdcDma::start(uint32_t pairRate, uint16_t oversampling) {
+    if (instance != nullptr || pairRate == 0) return false;
+    if (oversampling == 0 || oversampling > MAX_OVERSAMPLING) return false;
+    if ((oversampling & (oversampling - 1)) != 0) return false;
+
+    /* Every conversion of a trigger, oversampled, must end before the next. */
+    if ((uint64_t)pairRate * getStride() * oversampling * CONVERSION_CYCLES > SystemCoreClock) return false;
+    instance = this;
+
+    /* Pins to analog mode. */
+    for (uint8_t c = 0; c < channels; ++c) {
+        pinmap_pinout(voltagePins[c], PinMap_ADC);
+        pinmap_pinout(currentPins[c], PinMap_ADC);
+    }
+
+    /* ADC1, clocked from SYSCLK; CONVERSION_CYCLES assumes 24.5 cycle sampling. */
+    RCC_PeriphCLKInitTypeDef clkInit = {};
+    clkInit.PeriphClockSelection = RCC_PERIPHCLK_ADC;
+    clkInit.AdcClockSelection = RCC_ADCCLKSOURCE_SYSCLK;
+    if (HAL_RCCEx_PeriphCLKConfig(&clkInit) != HAL_OK) return false;
+    __HAL_RCC_ADC_CLK_ENABLE();
+
+    hadc.Instance = ADC1;
+    hadc.Init.ClockPrescaler = ADC_CLOCK_ASYNC_DIV1;
+    hadc.Init.Resolution = ADC_RESOLUTION_12B;
+    hadc.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc.Init.LowPowerAutoWait = DISABLE;
+    hadc.Init.ContinuousConvMode = DISABLE;
+    hadc.Init.NbrOfConversion = getStride();
+    hadc.Init.DiscontinuousConvMode = DISABLE;
+    hadc.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+    hadc.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc.Init.DMAContinuousRequests = ENABLE;
+    hadc.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+    hadc.Init.OversamplingMode = oversampling > 1 ? ENABLE : DISABLE;
+    if (oversampling > 1) {
+        uint8_t index = 0;
+        while ((2u << index) < oversampling) ++index;
+        hadc.Init.Oversampling.Ratio = OVERSAMPLING_RATIOS[index];
+        hadc.Init.Oversampling.RightBitShift = OVERSAMPLING_SHIFTS[index];
+        hadc.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+        hadc.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+    }
+    if (HAL_ADC_Init(&hadc) != HAL_OK) return false;
+
+    ADC_ChannelConfTypeDef chInit = {};
+    chInit.SamplingTime = ADC_SAMPLETIME_24CYCLES_5;
+    chInit.SingleDiff = ADC_SINGLE_ENDED;
+    chInit.OffsetNumber = ADC_OFFSET_NONE;
+    chInit.Offset = 0;
+    for (uint8_t c = 0; c < channels; ++c) {
+        chInit.Channel = adcChannel(voltagePins[c]);
+        chInit.Rank = REGULAR_RANKS[2 * c];
+        if (HAL_ADC_ConfigChannel(&hadc, &chInit) != HAL_OK) return false;
+        chInit.Channel = adcChannel(currentPins[c]);
+        chInit.Rank = REGULAR_RANKS[2 * c + 1];
+        if (HAL_ADC_ConfigChannel(&hadc, &chInit) != HAL_OK) return false;
+    }
+    if (HAL_ADCEx_Calibration_Start(&hadc, ADC_SINGLE_ENDED) != HAL_OK) return false;
+
+    /* DMA1 channel 1, request 0 is ADC1. */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma.Instance = DMA1_Channel1;
+    hdma.Init.Request = DMA_REQUEST_0;
+    hdma.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma.Init.MemInc = DMA_MINC_ENABLE;
+    hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma.Init.Mode = DMA_CIRCULAR;
+    hdma.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma) != HAL_OK) return false;
+    __HAL_LINKDMA(&hadc, DMA_Handle, hdma);
+
+    NVIC_SetVector(DMA1_Channel1_IRQn, (uint32_t)&AdcDma::dmaIrqHandler);
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+
+    /* TIM6 update event is the conversion trigger. */
+    uint32_t ticks = tim6Clock() / pairRate;
+    uint32_t prescaler = ticks / 0x10000;
+    uint32_t period = ticks / (prescaler + 1);
+    if (period < 2) return false;
+
+    __HAL_RCC_TIM6_CLK_ENABLE();
+    htim.Instance = TIM6;
+    htim.Init.Prescaler = prescaler;
+    htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim.Init.Period = period - 1;
+    htim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_Base_Init(&htim) != HAL_OK) return false;
+
+    TIM_MasterConfigTypeDef masterInit = {};
+    masterInit.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    masterInit.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim, &masterInit) != HAL_OK) return false;
+
+    uint64_t actualRate = tim6Clock() / ((prescaler + 1) * period);
+    blockPeriodUs = (uint64_t)BLOCK_PAIRS * 1000000 / actualRate;
+
+    produced = 0;
+    consumed = 0;
+    overruns = 0;
+    running = false;
+    return resume();
+}
+
+void AdcDma::stop(void) {
+    pause();
+    HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    instance = nullptr;
+}
+
+void AdcDma::pause(void) {
+    if (!running) return;
+    HAL_TIM_Base_Stop(&htim);
+    HAL_ADC_Stop_DMA(&hadc);
+    running = false;
+    sleep_manager_unlock_deep_sleep();
+}
+
+bool AdcDma::resume(void) {
+    if (running) return true;
+
+    /* TIM6 and the ADC stop in Stop 2; hold the MCU in sleep while converting. */
+    sleep_manager_lock_deep_sleep();
+
+    /* Arm the ADC and DMA first; nothing converts until TIM6 runs. */
+    flush();
+    if (HAL_ADC_Start_DMA(&hadc, (uint32_t *)buffer, 2 * BLOCK_PAIRS * getStride()) != HAL_OK
+        || HAL_TIM_Base_Start(&htim) != HAL_OK) {
+        sleep_manager_unlock_deep_sleep();
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+void AdcDma::attach(Callback<void(const uint16_t *)> handler) {
+    core_util_critical_section_enter();
+    this->handler = handler;
+    core_util_critical_section_exit();
+}
+
+void AdcDma::flush(void) {
+    core_util_critical_section_enter();
+    consumed = produced;
+    flags.clear(FLAG_BLOCK);
+    core_util_critical_section_exit();
+}
+
+const uint16_t *AdcDma::waitBlock(void) {
+    while (consumed == produced) {
+        uint32_t result = flags.wait_any_for(FLAG_BLOCK, BLOCK_TIMEOUT);
+        if (result & osFlagsError) return nullptr;
+    }
+
+    core_util_critical_section_enter();
+    uint32_t available = produced - consumed;
+    uint8_t half = lastHalf;
+    consumed = produced;
+    core_util_critical_section_exit();
+
+    /* Only the newest block is intact; older ones have been overwritten. */
+    if (available > 1) overruns += available - 1;
+    return &buffer[half * BLOCK_PAIRS * getStride()];
+}
+
+void AdcDma::sumBlock(const uint16_t *block, uint32_t *voltSum, uint32_t *currSum, uint8_t channel) const {
+    ::sumBlock<BLOCK_PAIRS>(block + 2 * channel, voltSum, currSum, getStride());
+}
+
+void AdcDma::accumulate(const uint16_t *block, Moments *moments, uint8_t channel) const {
+    accumulateBlock<BLOCK_PAIRS>(block + 2 * channel, moments, getStride());
+}
+
+void AdcDma::dmaIrqHandler(void) {
+    uint32_t isr = DMA1->ISR;
+    if (isr & DMA_ISR_HTIF1) {
+        DMA1->IFCR = DMA_IFCR_CHTIF1;
+        if (instance) instance->onBlock(0);
+    }
+    if (isr & DMA_ISR_TCIF1) {
+        DMA1->IFCR = DMA_IFCR_CTCIF1;
+        if (instance) instance->onBlock(1);
+    }
+    if (isr & DMA_ISR_TEIF1) {
+        DMA1->IFCR = DMA_IFCR_CTEIF1;
+    }
+}
+
+void AdcDma::onBlock(uint8_t half) {
+    if (handler) handler(&buffer[half * BLOCK_PAIRS * getStride()]);
+    lastHalf = half;
+    produced = produced + 1;
+    flags.set(FLAG_BLOCK);
+}
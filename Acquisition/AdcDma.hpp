@@ -0,0 +1,162 @@
+/**
+ * @file AdcDma.hpp
+ * @brief Timer triggered, DMA backed voltage/current acquisition engine.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The L432KC only has ADC1, so the voltage and current channels are
+ * converted as a two rank regular sequence started by each TIM6 update
+ * event. The two conversions of a pair are a few microseconds apart.
+ * DMA1 channel 1 writes the interleaved [V, I] codes into a circular
+ * buffer; the half and full transfer interrupts each complete one block
+ * and wake the consumer thread. TIM6 and DMA1 channel 1 are otherwise
+ * unused by mbed on this target; do not mix with AnalogIn on ADC1.
+ *
+ * With an oversampling ratio above one, the ADC hardware oversampler
+ * converts each channel of a pair ratio times back to back and delivers
+ * their sum, shifted down to at most 16 bits, as one DMA word. A block
+ * then averages BLOCK_PAIRS * ratio conversions per channel for no CPU
+ * time; the codes carry up to four fractional bits (see codeShift()).
+ *
+ * Several tracer channels share the sequence: each adds its own voltage
+ * and current ranks, so one trigger converts a [V, I] pair per channel
+ * and a block holds BLOCK_PAIRS triggers of getStride() codes. All of a
+ * trigger's conversions must end before the next, so the pair rate a
+ * channel gets falls with the channel count.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "BlockSums.hpp"
+
+class AdcDma {
+    public:
+        /** Number of voltage/current pairs in one block (half the buffer). */
+        static const uint16_t BLOCK_PAIRS = 64;
+        /** Full scale of a single 12-bit conversion. */
+        static const uint16_t FULL_SCALE = 0xFFF;
+        /** Largest hardware oversampling ratio. */
+        static const uint16_t MAX_OVERSAMPLING = 256;
+        /** ADC clock cycles per conversion: 24.5 sampling plus 12.5 SAR. */
+        static const uint32_t CONVERSION_CYCLES = 37;
+        /** Largest number of voltage/current channel pairs in the sequence. */
+        static const uint8_t MAX_CHANNELS = 2;
+
+        /**
+         * @brief Left shift taking the codes delivered at an oversampling
+         * ratio to Q12.4: 4 without oversampling, 0 from 16 upwards,
+         * where the oversampler shifts the sum down to Q12.4 itself.
+         */
+        static constexpr uint8_t codeShift(uint16_t ratio) {
+            return ratio >= 16 ? 0 : ratio >= 8 ? 1 : ratio >= 4 ? 2 : ratio >= 2 ? 3 : 4;
+        }
+
+        AdcDma(PinName voltagePin, PinName currentPin);
+
+        /**
+         * @param voltagePins Voltage sense pin of each channel.
+         * @param currentPins Current sense pin of each channel.
+         * @param channels Channel pairs, 1 to MAX_CHANNELS; more are ignored.
+         */
+        AdcDma(const PinName *voltagePins, const PinName *currentPins, uint8_t channels);
+
+        /**
+         * @brief Configure the ADC, DMA and trigger timer and start
+         * converting.
+         *
+         * @param pairRate Voltage/current pairs per second, per channel.
+         * @param oversampling Conversions summed per delivered code, a
+         * power of two up to MAX_OVERSAMPLING; 1 disables oversampling.
+         * @return true Acquisition is running.
+         * @return false The peripherals could not be configured, or the
+         * conversions of a pair do not fit in the trigger period.
+         */
+        bool start(uint32_t pairRate, uint16_t oversampling = 1);
+
+        /** Stop the trigger timer and the DMA stream. */
+        void stop(void);
+
+        /**
+         * @brief Stop converting but keep the configuration, e.g. to let
+         * the MCU enter Stop 2, where it is retained.
+         */
+        void pause(void);
+
+        /**
+         * @brief Convert again after pause(). The block count carries on
+         * from where it stopped.
+         *
+         * @return false The ADC or DMA could not be restarted.
+         */
+        bool resume(void);
+
+        /** Drop any completed blocks that have not been consumed yet. */
+        void flush(void);
+
+        /**
+         * @brief Sleep until the next block completes.
+         *
+         * @return const uint16_t* Interleaved [V, I] codes of every
+         * channel, BLOCK_PAIRS triggers of getStride() codes. Valid until the DMA wraps around to it, one block
+         * period later. nullptr on timeout.
+         */
+        const uint16_t *waitBlock(void);
+
+        /**
+         * @brief Call handler from the DMA ISR with every completed block,
+         * before any waiting thread is woken. Pass nullptr to detach.
+         */
+        void attach(Callback<void(const uint16_t *)> handler);
+
+        /** Accumulate the voltage and current codes of a channel in a block. */
+        void sumBlock(const uint16_t *block, uint32_t *voltSum, uint32_t *currSum, uint8_t channel = 0) const;
+
+        /**
+         * Accumulate the codes of a channel in a block and their squares,
+         * for the mean and RMS noise of a point.
+         */
+        void accumulate(const uint16_t *block, Moments *moments, uint8_t channel = 0) const;
+
+        /** Channel pairs in the sequence. */
+        uint8_t getChannels(void) const { return channels; }
+
+        /** Codes per trigger in a block: a [V, I] pair per channel. */
+        uint8_t getStride(void) const { return 2 * channels; }
+
+        /** Time taken to fill one block, in us. */
+        uint32_t getBlockPeriodUs(void) const { return blockPeriodUs; }
+
+        /** Number of blocks completed since start(); the acquisition clock. */
+        uint32_t getBlockCount(void) const { return produced; }
+
+        /** Number of blocks overwritten before they were consumed. */
+        uint32_t getOverruns(void) const { return overruns; }
+
+    private:
+        static void dmaIrqHandler(void);
+        void onBlock(uint8_t half);
+
+        static AdcDma *instance;
+
+        PinName voltagePins[MAX_CHANNELS];
+        PinName currentPins[MAX_CHANNELS];
+        uint8_t channels;
+        ADC_HandleTypeDef hadc;
+        DMA_HandleTypeDef hdma;
+        TIM_HandleTypeDef htim;
+        EventFlags flags;
+        Callback<void(const uint16_t *)> handler;
+
+        /** Interleaved [V, I] codes, two blocks long at MAX_CHANNELS. */
+        uint16_t buffer[4 * BLOCK_PAIRS * MAX_CHANNELS];
+        uint32_t blockPeriodUs;
+
+        bool running;
+
+        /* Written in the DMA ISR, read by the consumer. */
+        volatile uint32_t produced;
+        volatile uint8_t lastHalf;
+        uint32_t consumed;
+        uint32_t overruns;
+};
@@ -0,0 +1,50 @@
+/**
+ * @file BlockSums.hpp
+ * @brief Sums over a block of interleaved [V, I] ADC codes.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Free of any HAL, so the host bench runs the same code as the board.
+ * With several channels a block holds one [V, I] pair per channel for
+ * each trigger; pass the first pair of the channel and the codes per
+ * trigger as the stride.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Pipeline/Point.hpp"
+
+/** Accumulate the voltage and current codes of a block of PAIRS pairs. */
+template <uint16_t PAIRS>
+inline void sumBlock(const uint16_t *block, uint32_t *voltSum, uint32_t *currSum, uint8_t stride = 2) {
+    uint32_t v = 0;
+    uint32_t c = 0;
+    for (uint16_t k = 0; k < stride * PAIRS; k += stride) {
+        v += block[k];
+        c += block[k + 1];
+    }
+    *voltSum += v;
+    *currSum += c;
+}
+
+/** Accumulate the codes of a block and their squares. */
+template <uint16_t PAIRS>
+inline void accumulateBlock(const uint16_t *block, Moments *moments, uint8_t stride = 2) {
+    uint32_t v = 0;
+    uint32_t c = 0;
+    uint64_t vSq = 0;
+    uint64_t cSq = 0;
+    for (uint16_t k = 0; k < stride * PAIRS; k += stride) {
+        uint32_t vk = block[k];
+        uint32_t ck = block[k + 1];
+        v += vk;
+        c += ck;
+        vSq += vk * vk;
+        cSq += ck * ck;
+    }
+    moments->voltSum += v;
+    moments->currSum += c;
+    moments->voltSq += vSq;
+    moments->currSq += cSq;
+}
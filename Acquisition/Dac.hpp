@@ -0,0 +1,33 @@
+/**
+ * @file Dac.hpp
+ * @brief Direct DAC1 writes, bypassing the AnalogOut float path.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The channel must already be enabled, e.g. by an AnalogOut on A3. A
+ * write is a single store into the 12-bit right aligned holding register
+ * and is safe from an ISR; the output follows one APB clock later.
+ * Tracer channel 0 is driven from DAC1 output 1 (A3) and channel 1 from
+ * output 2 (A4); the second is enabled by an AnalogOut on A4 likewise.
+ */
+
+#pragma once
+#include "mbed.h"
+
+inline void dacWrite(uint16_t code) {
+    DAC1->DHR12R1 = code & DAC_DHR12R1_DACC1DHR;
+}
+
+inline uint16_t dacRead(void) {
+    return DAC1->DHR12R1 & DAC_DHR12R1_DACC1DHR;
+}
+
+/** Set the drive of a tracer channel. */
+inline void dacWrite(uint8_t channel, uint16_t code) {
+    if (channel == 0) {
+        DAC1->DHR12R1 = code & DAC_DHR12R1_DACC1DHR;
+    } else {
+        DAC1->DHR12R2 = code & DAC_DHR12R2_DACC2DHR;
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file Sequencer.cpp
+ * @brief Interrupt driven sweep sequencer locked to the acquisition clock.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "Sequencer.hpp"
+#include "Dac.hpp"
+#include "Diagnostics/DeviceClock.hpp"
+
+#define FLAG_POINT      0x1
+#define FLAG_DONE       0x2
+#define POINT_TIMEOUT   100ms
+
+Sequencer::Sequencer(AdcDma &adc) :
+    adc(adc),
+    codes(nullptr),
+    count(0),
+    forward(true),
+    settleBlocks(1),
+    sampleBlocks(1),
+    running(false),
+    step(0),
+    blockInStep(0),
+    current(),
+    dropped(0),
+    stalled(false) {}
+
+bool Sequencer::start(const uint16_t *codes, uint16_t count, bool forward, uint8_t settleBlocks, uint8_t sampleBlocks) {
+    if (running || codes == nullptr || count == 0) return false;
+
+    RawPoint stale;
+    while (ring.pop(&stale)) {}
+    flags.clear();
+
+    this->codes = codes;
+    this->count = count;
+    this->forward = forward;
+    this->settleBlocks = settleBlocks < 1 ? 1 : settleBlocks;
+    this->sampleBlocks = sampleBlocks < 1 ? 1 : sampleBlocks;
+    step = 0;
+    blockInStep = 0;
+    dropped = 0;
+    stalled = false;
+
+    /* The first code goes out now; the block in flight counts as settle. */
+    core_util_critical_section_enter();
+    dacWrite(code(0));
+    current = RawPoint();
+    running = true;
+    core_util_critical_section_exit();
+
+    adc.attach(callback(this, &Sequencer::onBlock));
+    return true;
+}
+
+bool Sequencer::collect(RawPoint *point) {
+    while (!ring.pop(point)) {
+        if (!running) {
+            adc.attach(nullptr);
+            return ring.pop(point);
+        }
+        uint32_t result = flags.wait_any_for(FLAG_POINT | FLAG_DONE, POINT_TIMEOUT);
+        if (result & osFlagsError) {
+            abort();
+            stalled = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Sequencer::abort(void) {
+    running = false;
+    adc.attach(nullptr);
+    flags.set(FLAG_DONE);
+}
+
+void Sequencer::onBlock(const uint16_t *block) {
+    if (!running) return;
+
+    ++blockInStep;
+    if (blockInStep <= settleBlocks) return;
+
+    adc.accumulate(block, &current.sums);
+    if (blockInStep < settleBlocks + sampleBlocks) return;
+
+    /* Step boundary: retime the DAC first, then publish. */
+    current.index = step;
+    current.tick = adc.getBlockCount() + 1;
+    current.timeUs = (uint32_t)DeviceClock::now();
+    if (++step < count) {
+        dacWrite(code(step));
+    } else {
+        running = false;
+    }
+    if (!ring.push(current)) dropped = dropped + 1;
+
+    current = RawPoint();
+    blockInStep = 0;
+    flags.set(running ? FLAG_POINT : FLAG_DONE);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file Sequencer.hpp
+ * @brief Interrupt driven sweep sequencer locked to the acquisition clock.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The sequencer steps on the AdcDma block interrupt, which TIM6 paces in
+ * hardware. Every step lasts exactly settleBlocks + sampleBlocks blocks:
+ * at the step boundary the ISR writes the next code of a DacTable straight
+ * into the DAC holding register, then sums the last sampleBlocks blocks
+ * and publishes the raw point through a lock-free ring. Step timing is
+ * therefore an exact multiple of the block period from run to run, and
+ * nothing in the ISR blocks or touches the FPU. The DAC must already be
+ * enabled, e.g. by an AnalogOut on DAC1 channel 1.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "AdcDma.hpp"
+#include "Pipeline/Point.hpp"
+#include "Pipeline/SpscRing.hpp"
+
+class Sequencer {
+    public:
+        explicit Sequencer(AdcDma &adc);
+
+        /**
+         * @brief Start stepping through a code table. The table must stay
+         * valid and unchanged until the run completes.
+         *
+         * @param codes 12-bit DAC codes, ascending.
+         * @param count Number of codes.
+         * @param forward Step through the codes from the first or the last.
+         * @param settleBlocks Blocks discarded after each DAC write, >= 1.
+         * @param sampleBlocks Blocks accumulated per point, >= 1.
+         * @return false A run is already in progress or the plan is empty.
+         */
+        bool start(const uint16_t *codes, uint16_t count, bool forward, uint8_t settleBlocks, uint8_t sampleBlocks);
+
+        /**
+         * @brief Sleep until the next point of the run is available.
+         *
+         * @return false The run is complete (or stalled) and drained.
+         */
+        bool collect(RawPoint *point);
+
+        /** Stop the run at the next block boundary. */
+        void abort(void);
+
+        /** Points dropped because the consumer fell a whole ring behind. */
+        uint32_t getDropped(void) const { return dropped; }
+
+        /** The last run ended because a point did not arrive in time. */
+        bool hasStalled(void) const { return stalled; }
+
+    private:
+        void onBlock(const uint16_t *block);
+        uint16_t code(uint16_t k) const { return forward ? codes[k] : codes[count - 1 - k]; }
+
+        AdcDma &adc;
+        EventFlags flags;
+        SpscRing<RawPoint, 32> ring;
+
+        /* Only written by the ISR while a run is active. */
+        const uint16_t *codes;
+        uint16_t count;
+        bool forward;
+        uint8_t settleBlocks;
+        uint8_t sampleBlocks;
+        volatile bool running;
+        uint16_t step;
+        uint8_t blockInStep;
+        RawPoint current;
+        volatile uint32_t dropped;
+        bool stalled;
+};
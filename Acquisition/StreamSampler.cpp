@@ -0,0 +1,136 @@
+/**
+ * @file StreamSampler.cpp
+ * @brief Continuous, decimated logging of the operating point at a fixed
+ * DAC code or dithered around the maximum power point.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "StreamSampler.hpp"
+#include "Dac.hpp"
+#include "Diagnostics/DeviceClock.hpp"
+
+#define FLAG_RECORD     0x1
+#define FLAG_DONE       0x2
+#define RECORD_TIMEOUT  1100ms // Longest record, at 1 Hz, and then some.
+
+StreamSampler::StreamSampler(AdcDma &adc) :
+    adc(adc),
+    running(false),
+    code(0),
+    ditherStep(0),
+    rising(true),
+    decimation(1),
+    settlePairs(0),
+    skip(0),
+    voltZero(0),
+    currZero(0),
+    primed(false),
+    lastPower(0),
+    index(0),
+    current(),
+    produced(0),
+    dropped(0) {}
+
+bool StreamSampler::start(
+    uint16_t code,
+    uint16_t ditherStep,
+    uint16_t decimation,
+    uint16_t settlePairs,
+    uint16_t voltZero,
+    uint16_t currZero
+) {
+    if (running) return false;
+
+    StreamRecord stale;
+    while (ring.pop(&stale)) {}
+    flags.clear();
+
+    this->code = code > DAC_DHR12R1_DACC1DHR ? DAC_DHR12R1_DACC1DHR : code;
+    this->ditherStep = ditherStep;
+    this->decimation = decimation < 1 ? 1 : decimation;
+    this->settlePairs = settlePairs;
+    this->voltZero = voltZero;
+    this->currZero = currZero;
+    rising = true;
+    primed = false;
+    index = 0;
+    produced = 0;
+    dropped = 0;
+
+    /* The block in flight straddles the DAC write; skip what is left of it. */
+    core_util_critical_section_enter();
+    dacWrite(this->code);
+    skip = AdcDma::BLOCK_PAIRS + settlePairs;
+    current = StreamRecord();
+    running = true;
+    core_util_critical_section_exit();
+
+    adc.attach(callback(this, &StreamSampler::onBlock));
+    return true;
+}
+
+bool StreamSampler::collect(StreamRecord *record) {
+    while (!ring.pop(record)) {
+        if (!running) {
+            adc.attach(nullptr);
+            return ring.pop(record);
+        }
+        uint32_t result = flags.wait_any_for(FLAG_RECORD | FLAG_DONE, RECORD_TIMEOUT);
+        if (result & osFlagsError) {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void StreamSampler::stop(void) {
+    running = false;
+    adc.attach(nullptr);
+    flags.set(FLAG_DONE);
+}
+
+void StreamSampler::onBlock(const uint16_t *block) {
+    if (!running) return;
+
+    uint8_t stride = adc.getStride();
+    for (uint16_t k = 0; k < AdcDma::BLOCK_PAIRS; ++k, block += stride) {
+        if (skip > 0) {
+            --skip;
+            continue;
+        }
+        int32_t v = block[0];
+        int32_t i = block[1];
+        current.voltSum += v;
+        current.currSum += i;
+        current.powerSum += (int64_t)(v - voltZero) * (i - currZero);
+        if (++current.pairs == decimation) finishRecord();
+    }
+}
+
+void StreamSampler::finishRecord(void) {
+    current.index = index++;
+    current.dacCode = code;
+    current.tick = adc.getBlockCount() + 1;
+    current.timeUs = (uint32_t)DeviceClock::now();
+    produced = produced + 1;
+    if (!ring.push(current)) dropped = dropped + 1;
+
+    /* Perturb and observe: keep going while the power rises. */
+    if (ditherStep != 0) {
+        if (primed && current.powerSum < lastPower) rising = !rising;
+        lastPower = current.powerSum;
+        primed = true;
+
+        if (rising && code + ditherStep > DAC_DHR12R1_DACC1DHR) rising = false;
+        if (!rising && code < ditherStep) rising = true;
+        code = rising ? code + ditherStep : code - ditherStep;
+        dacWrite(code);
+        skip = settlePairs;
+    }
+
+    current = StreamRecord();
+    flags.set(FLAG_RECORD);
+}
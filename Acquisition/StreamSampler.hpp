@@ -0,0 +1,110 @@
+/**
+ * @file StreamSampler.hpp
+ * @brief Continuous, decimated logging of the operating point at a fixed
+ * DAC code or dithered around the maximum power point.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The sampler runs on the AdcDma block interrupt like the Sequencer, so
+ * it sees every pair the DMA writes and never waits on anything. Every
+ * decimation pairs of channel 0 are summed into one record: the raw
+ * voltage and current codes and the products of both after removing
+ * their zero codes, so the mean power keeps the ripple that the product
+ * of the means would lose. Records go out through a lock-free ring; when
+ * the consumer falls a whole ring behind, new records are dropped and
+ * counted, and the record index shows the gap.
+ *
+ * With a dither step the ISR also tracks the maximum power point by
+ * perturb and observe: after every record it steps the DAC by the dither
+ * step, reversing whenever the power fell, and skips settlePairs pairs
+ * before summing again. Power is compared in raw codes; with the zero
+ * codes removed it is proportional to the calibrated power, and no FPU
+ * is touched in the ISR.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "AdcDma.hpp"
+#include "Pipeline/SpscRing.hpp"
+
+/** Sums of one decimated record, as produced in the sampler ISR. */
+struct StreamRecord {
+    uint16_t index;             /* Records since start, wrapping. */
+    uint16_t dacCode;           /* Code held while summing. */
+    uint16_t pairs;
+    uint32_t voltSum;           /* Raw codes. */
+    uint32_t currSum;
+    int64_t powerSum;           /* Sum of (v - voltZero) * (i - currZero), raw codes. */
+    uint32_t tick;              /* Acquisition block count when the record ended. */
+    uint32_t timeUs;            /* Device time when the record ended, low 32 bits. */
+};
+
+class StreamSampler {
+    public:
+        /** Records buffered between the ISR and the consumer. */
+        static const uint16_t RING_SIZE = 128;
+
+        explicit StreamSampler(AdcDma &adc);
+
+        /**
+         * @brief Start logging.
+         *
+         * @param code DAC code to hold, or to start dithering from.
+         * @param ditherStep DAC codes per perturb and observe step; 0
+         * holds code.
+         * @param decimation Pairs summed per record, >= 1.
+         * @param settlePairs Pairs skipped after each dither step.
+         * @param voltZero, currZero Raw codes of 0 V and 0 A.
+         * @return false A run is already in progress.
+         */
+        bool start(
+            uint16_t code,
+            uint16_t ditherStep,
+            uint16_t decimation,
+            uint16_t settlePairs,
+            uint16_t voltZero,
+            uint16_t currZero
+        );
+
+        /**
+         * @brief Sleep until the next record is available.
+         *
+         * @return false The run was stopped (or stalled) and is drained.
+         */
+        bool collect(StreamRecord *record);
+
+        /** Stop at the next block boundary. */
+        void stop(void);
+
+        /** Records completed since start(), including dropped ones. */
+        uint32_t getRecords(void) const { return produced; }
+
+        /** Records dropped because the consumer fell a whole ring behind. */
+        uint32_t getDropped(void) const { return dropped; }
+
+    private:
+        void onBlock(const uint16_t *block);
+        void finishRecord(void);
+
+        AdcDma &adc;
+        EventFlags flags;
+        SpscRing<StreamRecord, RING_SIZE> ring;
+
+        /* Only written by the ISR while a run is active. */
+        volatile bool running;
+        uint16_t code;
+        uint16_t ditherStep;
+        bool rising;                /* Dither direction. */
+        uint16_t decimation;
+        uint16_t settlePairs;
+        uint16_t skip;              /* Pairs left to skip. */
+        int32_t voltZero;
+        int32_t currZero;
+        bool primed;                /* lastPower holds a record. */
+        int64_t lastPower;
+        uint16_t index;
+        StreamRecord current;
+        volatile uint32_t produced;
+        volatile uint32_t dropped;
+};
@@ -0,0 +1,138 @@
+/**
+ * @file CurveExtractor.hpp
+ * @brief Incremental extraction of the IV curve figures of merit: Isc,
+ * Voc, Vmp, Imp, Pmax and fill factor.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * update() is integer only and keeps just the points each figure needs,
+ * so it works on points in any order. finish() then refines once per
+ * sweep: Isc and Voc are linear extrapolations of the two points nearest
+ * to each axis, and the power peak is the vertex of the parabola through
+ * the peak point and its two neighbours in the sweep.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Calibration/Calibration.hpp"
+
+/** Figures of merit of one sweep. Voltages in mV, currents in mA. */
+struct CurveSummary {
+    int32_t isc;
+    int32_t voc;
+    int32_t vmp;
+    int32_t imp;
+    int32_t pmax;               /* mW. */
+    uint16_t fillFactor;        /* Q0.16. */
+    uint16_t numPoints;
+};
+
+class CurveExtractor {
+    public:
+        CurveExtractor(void) { reset(); }
+
+        void reset(void) {
+            count = 0;
+            sincePeak = 0;
+            for (uint8_t k = 0; k < 2; ++k) {
+                lowV[k] = { INT32_MAX, 0 };
+                lowI[k] = { 0, INT32_MAX };
+            }
+        }
+
+        /** Feed the next calibrated point of the sweep. */
+        void update(const CalPoint &cal) {
+            Sample s = { cal.voltage, cal.current };
+
+            /* Two lowest voltages, for Isc. */
+            if (s.v < lowV[0].v) {
+                lowV[1] = lowV[0];
+                lowV[0] = s;
+            } else if (s.v < lowV[1].v) {
+                lowV[1] = s;
+            }
+
+            /* Two lowest currents, for Voc. */
+            if (s.i < lowI[0].i) {
+                lowI[1] = lowI[0];
+                lowI[0] = s;
+            } else if (s.i < lowI[1].i) {
+                lowI[1] = s;
+            }
+
+            /* Power peak and its neighbours in sweep order. */
+            int64_t p = (int64_t)s.v * s.i;
+            if (count == 0 || p > power(peak[1])) {
+                peak[0] = count == 0 ? s : previous;
+                peak[1] = s;
+                sincePeak = 0;
+            } else if (sincePeak == 0) {
+                peak[2] = s;
+                sincePeak = 1;
+            }
+            previous = s;
+            ++count;
+        }
+
+        /** Refine and return the figures of the points fed since reset(). */
+        CurveSummary finish(void) const {
+            CurveSummary out = {};
+            out.numPoints = count;
+            if (count < 2) return out;
+
+            out.isc = axisIntercept(lowV[0].v, lowV[0].i, lowV[1].v, lowV[1].i);
+            out.voc = axisIntercept(lowI[0].i, lowI[0].v, lowI[1].i, lowI[1].v);
+
+            /* Parabolic vertex through the peak; fall back to the point. */
+            float vmp = peak[1].v;
+            float imp = peak[1].i;
+            if (sincePeak && peak[0].v != peak[1].v && peak[2].v != peak[1].v && peak[0].v != peak[2].v) {
+                float x0 = peak[0].v, x1 = peak[1].v, x2 = peak[2].v;
+                float y0 = power(peak[0]), y1 = power(peak[1]), y2 = power(peak[2]);
+                float d0 = (y1 - y0) / (x1 - x0);
+                float d1 = (y2 - y1) / (x2 - x1);
+                float curvature = (d1 - d0) / (x2 - x0);
+                if (curvature < 0) {
+                    float v = (x0 + x1) / 2 - d0 / (2 * curvature);
+                    /* Current along the neighbouring segment toward v. */
+                    const Sample &n = (v >= x1) == (x2 > x1) ? peak[2] : peak[0];
+                    if (n.v != peak[1].v) {
+                        imp = peak[1].i + (v - x1) * (n.i - peak[1].i) / (n.v - x1);
+                        vmp = v;
+                    }
+                }
+            }
+            out.vmp = (int32_t)vmp;
+            out.imp = (int32_t)imp;
+            out.pmax = (int32_t)(vmp * imp / 1000);
+
+            float ideal = (float)out.voc * out.isc / 1000;
+            if (ideal > 0) {
+                float ff = out.pmax / ideal;
+                out.fillFactor = ff >= 1 ? 0xFFFF : ff <= 0 ? 0 : (uint16_t)(ff * 65536);
+            }
+            return out;
+        }
+
+    private:
+        struct Sample {
+            int32_t v;
+            int32_t i;
+        };
+
+        static int64_t power(const Sample &s) { return (int64_t)s.v * s.i; }
+
+        /** y at x = 0 on the line through (x0, y0) and (x1, y1). */
+        static int32_t axisIntercept(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+            if (x0 == x1) return y0;
+            return (int32_t)(y0 - (int64_t)x0 * (y1 - y0) / (x1 - x0));
+        }
+
+        uint16_t count;
+        uint8_t sincePeak;
+        Sample lowV[2];
+        Sample lowI[2];
+        Sample peak[3];         /* Before, at and after the peak. */
+        Sample previous;
+};
@@ -0,0 +1,136 @@
+/**
+ * @file HysteresisTracker.hpp
+ * @brief Forward/reverse difference of a pass pair at matching DAC codes,
+ * measured as the reverse pass goes by.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Panel capacitance makes a sweep that steps faster than the panel
+ * settles read high on the way up and low on the way down, so the two
+ * passes of a pair part where the curve is steep. The forward pass is
+ * kept as raw codes, 6 bytes a point; every reverse point is then looked
+ * up by its DAC code, which the forward codes hold in ascending order,
+ * and compared once calibrated. Only the figures of the pair are kept,
+ * so nothing waits for the reverse pass to end.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Calibration/Calibration.hpp"
+#include "Pipeline/Point.hpp"
+#include "Sweep/DacTable.hpp"
+
+/** Forward/reverse difference of one pass pair. */
+struct HysteresisReport {
+    uint16_t matched;           /* Reverse points with a forward point at the same code. */
+    int32_t maxCurrDiff;        /* Largest |I forward - I reverse|, mA. */
+    uint16_t maxDacCode;        /* Code of the largest current difference. */
+    int32_t meanCurrDiff;       /* Mean |I forward - I reverse|, mA. */
+    int32_t maxPowerDiff;       /* Largest |P forward - P reverse|, mW. */
+    uint16_t ratio;             /* maxPowerDiff over the forward peak power, Q0.16, saturating. */
+};
+
+class HysteresisTracker {
+    public:
+        static const uint16_t MAX_POINTS = DacTable::MAX_CODES;
+
+        HysteresisTracker(void) : count(0), reverse(false), peakPower(0) { clearSums(); }
+
+        /** Start a pass. A forward pass replaces the one kept. */
+        void begin(bool reverse) {
+            this->reverse = reverse;
+            if (!reverse) {
+                count = 0;
+                peakPower = 0;
+            }
+            clearSums();
+        }
+
+        /** Feed a point of the pass and its calibration. */
+        void update(const Point &point, const CalPoint &cal, const CalTable &table) {
+            if (!reverse) {
+                if (count == MAX_POINTS || (count > 0 && point.dacCode <= forward[count - 1].dacCode)) return;
+                forward[count++] = { point.dacCode, point.volt, point.curr };
+                int32_t power = (int32_t)((int64_t)cal.voltage * cal.current / 1000);
+                if (power > peakPower) peakPower = power;
+                return;
+            }
+
+            const Stored *match = find(point.dacCode);
+            if (match == nullptr) return;
+            CalPoint ahead = calibrate(table, match->dacCode, match->volt, match->curr);
+            int32_t currDiff = distance(ahead.current, cal.current);
+            int32_t powerDiff = distance(
+                (int32_t)((int64_t)ahead.voltage * ahead.current / 1000),
+                (int32_t)((int64_t)cal.voltage * cal.current / 1000)
+            );
+
+            ++matched;
+            currDiffSum += currDiff;
+            if (currDiff > maxCurrDiff) {
+                maxCurrDiff = currDiff;
+                maxDacCode = point.dacCode;
+            }
+            if (powerDiff > maxPowerDiff) maxPowerDiff = powerDiff;
+        }
+
+        /**
+         * @brief The figures of the pair, after its reverse pass.
+         *
+         * @return false No reverse point matched a forward one.
+         */
+        bool finish(HysteresisReport *report) const {
+            if (!reverse || matched == 0) return false;
+            report->matched = matched;
+            report->maxCurrDiff = maxCurrDiff;
+            report->maxDacCode = maxDacCode;
+            report->meanCurrDiff = (int32_t)(currDiffSum / matched);
+            report->maxPowerDiff = maxPowerDiff;
+            uint64_t ratio = peakPower > 0 ? ((uint64_t)maxPowerDiff << 16) / (uint32_t)peakPower : 0xFFFF;
+            report->ratio = ratio > 0xFFFF ? 0xFFFF : (uint16_t)ratio;
+            return true;
+        }
+
+    private:
+        struct Stored {
+            uint16_t dacCode;
+            uint16_t volt;              /* Mean raw codes, Q12.4. */
+            uint16_t curr;
+        };
+
+        static int32_t distance(int32_t a, int32_t b) { return a > b ? a - b : b - a; }
+
+        /** Forward point at a code, by bisection. */
+        const Stored *find(uint16_t dacCode) const {
+            uint16_t low = 0;
+            uint16_t high = count;
+            while (low < high) {
+                uint16_t mid = (low + high) / 2;
+                if (forward[mid].dacCode < dacCode) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low < count && forward[low].dacCode == dacCode ? &forward[low] : nullptr;
+        }
+
+        void clearSums(void) {
+            matched = 0;
+            currDiffSum = 0;
+            maxCurrDiff = 0;
+            maxDacCode = 0;
+            maxPowerDiff = 0;
+        }
+
+        Stored forward[MAX_POINTS];
+        uint16_t count;
+        bool reverse;
+        int32_t peakPower;          /* mW, forward pass. */
+        uint16_t matched;
+        int64_t currDiffSum;
+        int32_t maxCurrDiff;
+        uint16_t maxDacCode;
+        int32_t maxPowerDiff;
+};
@@ -0,0 +1,51 @@
+/**
+ * @file Noise.hpp
+ * @brief Integer RMS noise of a point from the sums of its raw codes.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The noise is the standard deviation of the individual codes delivered
+ * by the ADC (each already hardware oversampled, if enabled), not of
+ * their mean; the host can divide by the square root of the sample count
+ * for the standard error of the point.
+ */
+
+#pragma once
+#include <stdint.h>
+
+/** Floor of the square root of x. */
+inline uint32_t isqrt(uint64_t x) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * @brief RMS deviation of count codes from their mean, in Q12.4 codes,
+ * saturating at 0xFF.
+ *
+ * @param sum Sum of the codes.
+ * @param sumSq Sum of the squares of the codes.
+ * @param count Number of codes.
+ * @param shift Left shift taking a code to Q12.4.
+ */
+inline uint8_t rmsNoise(uint32_t sum, uint64_t sumSq, uint32_t count, uint8_t shift) {
+    /* count^2 * variance, exact in integers. */
+    uint64_t scaled = (uint64_t)count * sumSq;
+    uint64_t square = (uint64_t)sum * sum;
+    if (count == 0 || scaled <= square) return 0;
+
+    uint32_t rms = isqrt((scaled - square) << (2 * shift)) / count;
+    return rms > 0xFF ? 0xFF : (uint8_t)rms;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file SpeedTuner.hpp
+ * @brief Searches for the shortest settle time whose pass pairs keep
+ * their hysteresis under a limit.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The tuner brackets the answer between the fastest settle time seen to
+ * pass and the slowest seen to fail, halving the first until something
+ * fails and doubling the second until something passes, then bisecting
+ * down to the resolution. Results arrive a few passes after the sweep
+ * that was run, so each one is taken for the settle time it was measured
+ * at rather than the one asked for last. A failure at the time it
+ * settled on reopens the search, e.g. when the panel or the light
+ * changes.
+ */
+
+#pragma once
+#include <stdint.h>
+
+class SpeedTuner {
+    public:
+        /**
+         * @param minUs, maxUs Bounds of the settle time.
+         * @param resolutionUs Bracket width at which the search stops.
+         */
+        SpeedTuner(uint32_t minUs, uint32_t maxUs, uint32_t resolutionUs) :
+            minUs(minUs),
+            maxUs(maxUs),
+            resolutionUs(resolutionUs),
+            current(maxUs),
+            best(0),
+            fail(0) {}
+
+        /** Start over from a settle time. */
+        void reset(uint32_t startUs) {
+            current = clamp(startUs);
+            best = 0;
+            fail = 0;
+        }
+
+        /** Settle time to sweep with next. May be read from another thread. */
+        uint32_t get(void) const { return current; }
+
+        /** The bracket is down to the resolution. */
+        bool isConverged(void) const { return best != 0 && (best <= minUs || best - fail <= resolutionUs); }
+
+        /** Take the verdict of a pass pair swept with settleUs. */
+        void update(uint32_t settleUs, bool within) {
+            if (within) {
+                if (best == 0 || settleUs < best) best = settleUs;
+                if (fail >= best) fail = 0;
+            } else {
+                if (settleUs > fail) fail = settleUs;
+                if (best != 0 && best <= fail) best = 0;
+            }
+
+            uint32_t next;
+            if (best == 0) {
+                next = fail == 0 ? current : fail * 2;
+            } else if (isConverged()) {
+                next = best;
+            } else if (fail == 0) {
+                next = best / 2;
+            } else {
+                next = fail + (best - fail) / 2;
+            }
+            current = clamp(next);
+        }
+
+    private:
+        uint32_t clamp(uint32_t us) const { return us < minUs ? minUs : us > maxUs ? maxUs : us; }
+
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint32_t resolutionUs;
+        volatile uint32_t current;
+        uint32_t best;              /* Fastest passing so far; 0 for none. */
+        uint32_t fail;              /* Slowest failing so far; 0 for none. */
+};
@@ -0,0 +1,169 @@
+/**
+ * @file CalStore.cpp
+ * @brief Per board calibration, kept in the last flash page and loaded
+ * into RAM tables at boot.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "CalStore.hpp"
+#include "Protocol/Crc.hpp"
+
+/** Big endian fields of the record. */
+static uint32_t getField(const uint8_t *in, uint8_t width) {
+    uint32_t value = 0;
+    for (uint8_t k = 0; k < width; ++k) value = (value << 8) | in[k];
+    return value;
+}
+
+static void putField(uint8_t *out, uint32_t value, uint8_t width) {
+    for (uint8_t k = 0; k < width; ++k) out[k] = (uint8_t)(value >> (8 * (width - 1 - k)));
+}
+
+/** First address of the last flash page; 0 if there is no flash. */
+static uint32_t pageAddress(FlashIAP &flash, uint32_t *size) {
+    uint32_t end = flash.get_flash_start() + flash.get_flash_size();
+    *size = flash.get_sector_size(end - 1);
+    return *size == MBED_FLASH_INVALID_SIZE ? 0 : end - *size;
+}
+
+CalStore::CalStore(void) :
+    banks(),
+    knots(),
+    active(DEFAULT_CAL),
+    spare(0),
+    loaded(false),
+    revision(0),
+    crc(0),
+    staged() {}
+
+bool CalStore::load(void) {
+    FlashIAP flash;
+    uint32_t size;
+    if (flash.init() != 0) return false;
+    uint32_t page = pageAddress(flash, &size);
+    bool found = page != 0 && flash.read(staged, page, RECORD_SIZE) == 0 && parse(staged);
+    flash.deinit();
+    return found;
+}
+
+enum CalStatus CalStore::stage(uint16_t offset, const uint8_t *data, uint8_t len) {
+    if ((uint32_t)offset + len > RECORD_SIZE) return CAL_BAD_OFFSET;
+    for (uint8_t k = 0; k < len; ++k) staged[offset + k] = data[k];
+    return CAL_OK;
+}
+
+enum CalStatus CalStore::commit(void) {
+    /* Checked before the page is touched, so a bad record leaves the old one. */
+    uint8_t image[RECORD_SIZE];
+    core_util_critical_section_enter();
+    for (uint16_t k = 0; k < RECORD_SIZE; ++k) image[k] = staged[k];
+    core_util_critical_section_exit();
+    if (!check(image)) return CAL_BAD_RECORD;
+    enum CalStatus status = program(image);
+    if (status == CAL_OK) parse(image);
+    return status;
+}
+
+enum CalStatus CalStore::save(const CalTable *tables, uint16_t revision) {
+    uint8_t image[RECORD_SIZE];
+    serialize(tables, revision, image);
+    enum CalStatus status = program(image);
+    if (status == CAL_OK) parse(image);
+    return status;
+}
+
+bool CalStore::check(const uint8_t *image) const {
+    if (getField(image, 4) != MAGIC) return false;
+    if (getField(image + 4, 2) != VERSION) return false;
+    if (getField(image + 6, 2) != RECORD_SIZE || image[10] != NUM_MODES) return false;
+    return crc32(image, RECORD_SIZE - 4) == getField(image + RECORD_SIZE - 4, 4);
+}
+
+/**
+ * Decode a record into the spare bank and swap it in. The inputs of each
+ * term are fixed by its place in the table, so the segment shifts come
+ * from the built-in tables.
+ */
+bool CalStore::parse(const uint8_t *image) {
+    if (!check(image)) return false;
+
+    const uint8_t *in = image + HEADER_SIZE;
+    for (uint8_t m = 0; m < NUM_MODES; ++m) {
+        CalTable &table = banks[spare][m];
+        table = DEFAULT_CAL[m];
+        table.seriesDrop = (int32_t)getField(in, 4);
+        in += 4;
+        for (uint8_t t = 0; t < NUM_CAL_TERMS; ++t) {
+            CalTerm &term = termAt(table, t);
+            term.gain = (int32_t)getField(in, 4);
+            term.offset = (int32_t)getField(in + 4, 4);
+            term.correction = (in[8] & 0x1) ? knots[spare][m][t] : nullptr;
+            for (uint8_t k = 0; k < CAL_KNOTS; ++k) {
+                knots[spare][m][t][k] = (int16_t)getField(in + 10 + 2 * k, 2);
+            }
+            in += TERM_SIZE;
+        }
+    }
+
+    active = banks[spare];
+    spare ^= 1;
+    revision = (uint16_t)getField(image + 8, 2);
+    crc = getField(image + RECORD_SIZE - 4, 4);
+    loaded = true;
+    return true;
+}
+
+void CalStore::serialize(const CalTable *tables, uint16_t revision, uint8_t *image) const {
+    putField(image, MAGIC, 4);
+    putField(image + 4, VERSION, 2);
+    putField(image + 6, RECORD_SIZE, 2);
+    putField(image + 8, revision, 2);
+    image[10] = NUM_MODES;
+    image[11] = 0;
+
+    uint8_t *out = image + HEADER_SIZE;
+    for (uint8_t m = 0; m < NUM_MODES; ++m) {
+        putField(out, (uint32_t)tables[m].seriesDrop, 4);
+        out += 4;
+        for (uint8_t t = 0; t < NUM_CAL_TERMS; ++t) {
+            const CalTerm &term = termAt(tables[m], t);
+            putField(out, (uint32_t)term.gain, 4);
+            putField(out + 4, (uint32_t)term.offset, 4);
+            out[8] = term.correction != nullptr ? 0x1 : 0x0;
+            out[9] = 0;
+            for (uint8_t k = 0; k < CAL_KNOTS; ++k) {
+                putField(out + 10 + 2 * k, term.correction != nullptr ? (uint16_t)term.correction[k] : 0, 2);
+            }
+            out += TERM_SIZE;
+        }
+    }
+    putField(out, crc32(image, RECORD_SIZE - 4), 4);
+}
+
+enum CalStatus CalStore::program(const uint8_t *image) {
+    FlashIAP flash;
+    uint32_t size;
+    if (flash.init() != 0) return CAL_FLASH_ERROR;
+    uint32_t page = pageAddress(flash, &size);
+
+    enum CalStatus status = CAL_OK;
+#ifdef FLASHIAP_APP_ROM_END_ADDR
+    if (page < FLASHIAP_APP_ROM_END_ADDR) status = CAL_NOT_RESERVED;
+#endif
+    if (status == CAL_OK && page == 0) status = CAL_FLASH_ERROR;
+    if (status == CAL_OK && flash.erase(page, size) != 0) status = CAL_FLASH_ERROR;
+    if (status == CAL_OK && flash.program(image, page, RECORD_SIZE) != 0) status = CAL_FLASH_ERROR;
+
+    /* Read back, so a failed write is reported rather than found at the next boot. */
+    if (status == CAL_OK) {
+        uint8_t readBack[RECORD_SIZE];
+        if (flash.read(readBack, page, RECORD_SIZE) != 0) status = CAL_FLASH_ERROR;
+        for (uint16_t k = 0; status == CAL_OK && k < RECORD_SIZE; ++k) {
+            if (readBack[k] != image[k]) status = CAL_FLASH_ERROR;
+        }
+    }
+    flash.deinit();
+    return status;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file CalStore.hpp
+ * @brief Per board calibration, kept in the last flash page and loaded
+ * into RAM tables at boot.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The record is a big endian byte image, laid out in the README, with
+ * its own format version, a revision chosen by whoever wrote it and a
+ * CRC-32. The host sends it in chunks with stage() and has it checked,
+ * programmed and applied with commit(); save() does the same for tables
+ * built on the board. Without a valid record the built-in DEFAULT_CAL is
+ * used. Lookups go through two RAM banks, so a new record is built in
+ * the idle one and swapped in with one pointer write.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "Calibration.hpp"
+
+enum CalStatus {
+    CAL_OK,
+    CAL_BAD_CRC,                /* A frame failed its CRC-8. */
+    CAL_BAD_OFFSET,             /* A chunk falls outside the record. */
+    CAL_BAD_RECORD,             /* Magic, version, length or CRC-32 wrong. */
+    CAL_FLASH_ERROR,            /* Erase, program or verify failed. */
+    CAL_NOT_RESERVED,           /* The page overlaps the firmware image. */
+    CAL_TOO_FEW_READINGS,       /* No term had two distinct readings to fit. */
+    CAL_BAD_REGIME,             /* A reference names no regime. */
+    CAL_QUEUE_FULL,             /* References arrive faster than they are measured. */
+    CAL_BUSY                    /* A stream is running on the tables in use. */
+};
+
+class CalStore {
+    public:
+        static const uint32_t MAGIC = 0x5056434C; // "PVCL"
+        static const uint16_t VERSION = 1;
+        /** Per term: gain, offset, correction flag, reserved, knots. */
+        static const uint16_t TERM_SIZE = 10 + 2 * CAL_KNOTS;
+        /** Per mode: series drop, then the DAC, voltage and current terms. */
+        static const uint16_t MODE_SIZE = 4 + NUM_CAL_TERMS * TERM_SIZE;
+        static const uint16_t HEADER_SIZE = 12;
+        static const uint16_t RECORD_SIZE = HEADER_SIZE + NUM_MODES * MODE_SIZE + 4;
+        static_assert(RECORD_SIZE % 8 == 0, "Flash is programmed in double words.");
+
+        CalStore(void);
+
+        /**
+         * @brief Load the record from flash, or fall back to DEFAULT_CAL.
+         *
+         * @return true A valid record was found.
+         */
+        bool load(void);
+
+        /**
+         * Table of a regime. The reference stays valid until a second swap,
+         * so hold it no longer than a point, or keep commits out meanwhile.
+         */
+        const CalTable &table(uint8_t mode) const { return active[mode < NUM_MODES ? mode : (uint8_t)MODULE]; }
+
+        /** Copy a chunk of a record sent by the host. May be called from an ISR. */
+        enum CalStatus stage(uint16_t offset, const uint8_t *data, uint8_t len);
+
+        /** Check the staged record, program it and apply it. Stalls the CPU while the page erases. */
+        enum CalStatus commit(void);
+
+        /** Write tables built on the board under a new revision and apply them. */
+        enum CalStatus save(const CalTable *tables, uint16_t revision);
+
+        /** Revision of the record in use; 0 for the built-in tables. */
+        uint16_t getRevision(void) const { return revision; }
+        /** CRC-32 of the record in use; 0 for the built-in tables. */
+        uint32_t getCrc(void) const { return crc; }
+        /** A record from flash or the host is in use. */
+        bool isLoaded(void) const { return loaded; }
+
+    private:
+        bool check(const uint8_t *image) const;
+        bool parse(const uint8_t *image);
+        void serialize(const CalTable *tables, uint16_t revision, uint8_t *image) const;
+        enum CalStatus program(const uint8_t *image);
+
+        CalTable banks[2][NUM_MODES];
+        int16_t knots[2][NUM_MODES][NUM_CAL_TERMS][CAL_KNOTS];
+        const CalTable *volatile active;
+        uint8_t spare;              /* Bank not in use. */
+        bool loaded;
+        uint16_t revision;
+        uint32_t crc;
+        uint8_t staged[RECORD_SIZE];
+};
@@ -0,0 +1,27 @@
+/**
+ * @file Calibration.cpp
+ * @brief Built-in calibration of the Array-CurveTracerPCB.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "Calibration.hpp"
+#include "Sweep/ModeTraits.hpp"
+
+/** Built-in table of a regime, assembled from its traits. */
+template <enum Mode M>
+static constexpr CalTable defaultTable(void) {
+    return CalTable {
+        ModeTraits<M>::dac(),
+        ModeTraits<M>::voltage(),
+        ModeTraits<M>::current(),
+        0
+    };
+}
+
+const CalTable DEFAULT_CAL[NUM_MODES] = {
+    defaultTable<CELL>(),
+    defaultTable<MODULE>(),
+    defaultTable<ARRAY>(),
+};
@@ -0,0 +1,145 @@
+/**
+ * @file Calibration.hpp
+ * @brief Fixed-point sensor and DAC calibration.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Every term is linear, out = in * gain + offset, with the gain in Q16.16
+ * milli-units per input LSB and the offset in milli-units; outputs are
+ * mV and mA. Sensor inputs are mean ADC codes in Q12.4, DAC inputs are
+ * plain 12-bit codes. A product is at most 16 x 32 bits, which the M4
+ * does in one SMULL, so no step needs the FPU or a divide.
+ *
+ * A term may add a piecewise linear correction on top: residuals at
+ * CAL_KNOTS evenly spaced inputs, so the segment of an input is a shift
+ * and the interpolation one multiply. Tables are loaded per board from
+ * the calibration store; the built-in ones have none.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Sweep/Mode.hpp"
+
+/** Segments of a correction table, over the whole input range. */
+static const uint8_t CAL_SEGMENTS = 16;
+static const uint8_t CAL_KNOTS = CAL_SEGMENTS + 1;
+
+struct CalTerm {
+    int32_t gain;               /* Q16.16 milli-units per input LSB. */
+    int32_t offset;             /* Milli-units. */
+    const int16_t *correction;  /* CAL_KNOTS residuals in milli-units, or nullptr. */
+    uint8_t segmentShift;       /* log2 of the input LSBs per segment. */
+
+    int32_t apply(int32_t in) const {
+        int32_t out = (int32_t)(((int64_t)in * gain) >> 16) + offset;
+        if (correction != nullptr) out += correct(in);
+        return out;
+    }
+
+    /** Interpolated residual at an input. */
+    int32_t correct(int32_t in) const {
+        uint32_t segment = in > 0 ? (uint32_t)in >> segmentShift : 0;
+        if (segment >= CAL_SEGMENTS) return correction[CAL_SEGMENTS];
+        int32_t frac = in & ((1 << segmentShift) - 1);
+        int32_t rise = correction[segment + 1] - correction[segment];
+        return correction[segment] + ((rise * frac) >> segmentShift);
+    }
+};
+
+/** Input at which a term's linear part outputs 0, clamped to 0 - full scale. */
+inline int32_t zeroInput(const CalTerm &term, int32_t inputFullScale) {
+    if (term.gain == 0) return 0;
+    int32_t in = (int32_t)(-((int64_t)term.offset << 16) / term.gain);
+    return in < 0 ? 0 : in > inputFullScale ? inputFullScale : in;
+}
+
+/** Bits needed to hold n. */
+constexpr uint8_t bitLength(uint32_t n) {
+    return n == 0 ? 0 : 1 + bitLength(n >> 1);
+}
+
+/** Segment shift spreading CAL_SEGMENTS over inputs up to inputFullScale. */
+constexpr uint8_t calSegmentShift(uint32_t inputFullScale) {
+    return bitLength(inputFullScale) - bitLength(CAL_SEGMENTS - 1);
+}
+
+/**
+ * @brief Build a term from the engineering units at input full scale and
+ * the offset in the same units.
+ */
+constexpr CalTerm calTerm(double fullScale, double offset, double inputFullScale) {
+    return CalTerm {
+        (int32_t)(fullScale * 1000.0 * 65536.0 / inputFullScale + 0.5),
+        (int32_t)(offset * 1000.0 + (offset < 0 ? -0.5 : 0.5)),
+        nullptr,
+        calSegmentShift((uint32_t)inputFullScale)
+    };
+}
+
+/** Full scale of a Q12.4 mean ADC code. */
+static const uint32_t SENSOR_FULL_SCALE = 0xFFF * 16;
+/** Full scale of a DAC code. */
+static const uint32_t DAC_CODE_FULL_SCALE = 0xFFF;
+
+/** Calibration of one test regime. */
+struct CalTable {
+    CalTerm dac;                /* DAC code to gate voltage, mV. */
+    CalTerm voltage;            /* Q12.4 code to sensed voltage, mV. */
+    CalTerm current;            /* Q12.4 code to sensed current, mA. */
+    int32_t seriesDrop;         /* Q16.16 mV per mA dropped on the PCB ahead of the voltage sensor. */
+};
+
+/** Terms of a table, in calibration record order. */
+enum CalTermIndex {
+    CAL_DAC,
+    CAL_VOLTAGE,
+    CAL_CURRENT,
+    NUM_CAL_TERMS
+};
+
+inline CalTerm &termAt(CalTable &table, uint8_t k) {
+    return k == CAL_DAC ? table.dac : k == CAL_VOLTAGE ? table.voltage : table.current;
+}
+
+inline const CalTerm &termAt(const CalTable &table, uint8_t k) {
+    return k == CAL_DAC ? table.dac : k == CAL_VOLTAGE ? table.voltage : table.current;
+}
+
+/** Built-in calibration, indexed by Mode. */
+extern const CalTable DEFAULT_CAL[NUM_MODES];
+
+/** Calibrated point, in mV and mA. */
+struct CalPoint {
+    int32_t gate;
+    int32_t voltage;
+    int32_t current;
+};
+
+inline CalPoint calibrate(const CalTable &table, uint16_t dacCode, uint16_t volt, uint16_t curr) {
+    CalPoint out;
+    out.gate = table.dac.apply(dacCode);
+    out.current = table.current.apply(curr);
+    out.voltage = table.voltage.apply(volt) + (int32_t)(((int64_t)out.current * table.seriesDrop) >> 16);
+    return out;
+}
+
+/**
+ * @brief Calibrate a run of interleaved [V, I] codes in place of one
+ * point at a time, e.g. a whole DMA block. Codes may be raw 12-bit
+ * samples if shift is 4, or Q12.4 means if shift is 0.
+ */
+inline void calibrateBlock(
+    const CalTable &table,
+    const uint16_t *codes,
+    uint16_t pairs,
+    uint8_t shift,
+    int32_t *volt,
+    int32_t *curr
+) {
+    for (uint16_t k = 0; k < pairs; ++k) {
+        curr[k] = table.current.apply((int32_t)codes[2 * k + 1] << shift);
+        volt[k] = table.voltage.apply((int32_t)codes[2 * k] << shift)
+            + (int32_t)(((int64_t)curr[k] * table.seriesDrop) >> 16);
+    }
+}
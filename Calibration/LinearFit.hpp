@@ -0,0 +1,80 @@
+/**
+ * @file LinearFit.hpp
+ * @brief Least squares line through calibration readings, as a term.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Readings are summed exactly in 64-bit integers as they come, so the
+ * fit itself is one pass over six sums; only the final divisions are
+ * done in floating point, once per term. The sums stay exact for up to
+ * MAX_READINGS readings of 16-bit inputs and outputs within +-2^20.
+ */
+
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include "Calibration.hpp"
+
+class LinearFit {
+    public:
+        static const uint16_t MAX_READINGS = 4096;
+
+        LinearFit(void) { reset(); }
+
+        void reset(void) {
+            n = 0;
+            sx = sy = sxx = sxy = syy = 0;
+        }
+
+        /**
+         * @brief Add a reading: an input code and the reference output, in
+         * milli-units.
+         *
+         * @return false The fit is full; the reading was dropped.
+         */
+        bool add(int32_t x, int32_t y) {
+            if (n >= MAX_READINGS) return false;
+            ++n;
+            sx += x;
+            sy += y;
+            sxx += (int64_t)x * x;
+            sxy += (int64_t)x * y;
+            syy += (int64_t)y * y;
+            return true;
+        }
+
+        uint16_t count(void) const { return n; }
+
+        /**
+         * @brief Fit out = in * gain + offset. The correction of the term, if
+         * any, is dropped; its segment shift is kept.
+         *
+         * @param rms RMS residual of the readings, milli-units.
+         * @return false Fewer than two distinct inputs.
+         */
+        bool solve(CalTerm *term, uint32_t *rms) const {
+            int64_t den = (int64_t)n * sxx - sx * sx;
+            if (n < 2 || den <= 0) return false;
+            double slope = (double)((int64_t)n * sxy - sx * sy) / (double)den;
+            double offset = ((double)sy - slope * (double)sx) / n;
+
+            /* Sum of squared residuals, expanded over the sums. */
+            double sse = (double)syy + slope * slope * (double)sxx + offset * offset * n
+                - 2.0 * slope * (double)sxy - 2.0 * offset * (double)sy + 2.0 * slope * offset * (double)sx;
+            *rms = (uint32_t)(sqrt(sse > 0.0 ? sse / n : 0.0) + 0.5);
+
+            term->gain = (int32_t)lround(slope * 65536.0);
+            term->offset = (int32_t)lround(offset);
+            term->correction = nullptr;
+            return true;
+        }
+
+    private:
+        uint16_t n;
+        int64_t sx;
+        int64_t sy;
+        int64_t sxx;
+        int64_t sxy;
+        int64_t syy;
+};
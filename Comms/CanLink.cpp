@@ -0,0 +1,115 @@
+/**
+ * @file CanLink.cpp
+ * @brief Interrupt driven CAN link to the Blackbody bus.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "CanLink.hpp"
+
+#define START_TIMEOUT   10 // ms, for the controller to join the bus.
+
+CanLink::CanLink(PinName rd, PinName td) :
+    rd(rd),
+    td(td),
+    can(),
+    syncId(0),
+    sent(0),
+    dropped(0),
+    rxDropped(0) {}
+
+bool CanLink::start(uint32_t hz) {
+    if (hz == 0) return false;
+    can_init_freq(&can, rd, td, hz);
+
+    /*
+     * can_init_freq() reports nothing. The controller leaves
+     * initialization once it sees the bus idle, and stays in it with a bad
+     * bit timing or a stuck RX line.
+     */
+    for (uint8_t k = 0; k < START_TIMEOUT && (CAN1->MSR & CAN_MSR_INAK) != 0; ++k) {
+        ThisThread::sleep_for(1ms);
+    }
+    if ((CAN1->MSR & CAN_MSR_INAK) != 0) return false;
+
+    can_irq_init(&can, &CanLink::irqHandler, (uintptr_t)this);
+    can_irq_set(&can, IRQ_TX, 1);
+    return true;
+}
+
+bool CanLink::accept(const uint16_t *ids, uint8_t numIds) {
+    if (numIds == 0 || numIds > MAX_FILTERS) return false;
+
+    /* Bank 0 accepts everything after can_init_freq(); overwrite it first. */
+    for (uint8_t k = 0; k < numIds; ++k) {
+        if (can_filter(&can, ids[k], 0x7FF, CANStandard, k) == 0) return false;
+    }
+    can_irq_set(&can, IRQ_RX, 1);
+    return true;
+}
+
+void CanLink::attachClock(Callback<uint32_t(void)> clock) {
+    core_util_critical_section_enter();
+    this->clock = clock;
+    core_util_critical_section_exit();
+}
+
+void CanLink::attachSync(uint16_t id, Callback<void(const CanFrame &frame)> handler) {
+    core_util_critical_section_enter();
+    syncId = id;
+    onSync = handler;
+    core_util_critical_section_exit();
+}
+
+bool CanLink::post(uint16_t id, const uint8_t *data, uint8_t len) {
+    CAN_Message msg = {};
+    msg.id = id;
+    msg.len = len > 8 ? 8 : len;
+    msg.format = CANStandard;
+    msg.type = CANData;
+    memcpy(msg.data, data, msg.len);
+
+    /*
+     * Masked, so that several threads may post; the TX interrupt only
+     * fires on completion, so kick an idle controller too.
+     */
+    core_util_critical_section_enter();
+    bool queued = txRing.push(msg);
+    if (!queued) dropped = dropped + 1;
+    pump();
+    core_util_critical_section_exit();
+    return queued;
+}
+
+void CanLink::pump(void) {
+    CAN_Message msg;
+    while ((CAN1->TSR & CAN_TSR_TME) != 0 && txRing.pop(&msg)) {
+        if (can_write(&can, msg, 0)) {
+            sent = sent + 1;
+        } else {
+            dropped = dropped + 1;
+        }
+    }
+}
+
+void CanLink::drain(void) {
+    CanFrame frame;
+    uint32_t tick = clock ? clock() : 0;
+    uint64_t timeUs = DeviceClock::now();
+    while (can_read(&can, &frame.msg, 0)) {
+        frame.tick = tick;
+        frame.timeUs = timeUs;
+        if (onSync && frame.msg.id == syncId) {
+            onSync(frame);
+        } else if (!rxRing.push(frame)) {
+            rxDropped = rxDropped + 1;
+        }
+    }
+}
+
+void CanLink::irqHandler(uintptr_t context, CanIrqType type) {
+    CanLink *self = (CanLink *)context;
+    if (type == IRQ_TX) self->pump();
+    else if (type == IRQ_RX) self->drain();
+}
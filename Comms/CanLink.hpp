@@ -0,0 +1,114 @@
+/**
+ * @file CanLink.hpp
+ * @brief Interrupt driven CAN link to the Blackbody bus.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * post() only copies a frame into a bounded ring and returns;
+ * the frames are moved into the three bxCAN transmit mailboxes by the
+ * TX complete interrupt, or straight away when a mailbox is already
+ * free. A full ring drops the new frame and counts it, so a slow or
+ * unplugged bus never stalls the caller.
+ *
+ * Inbound frames are filtered by ID in the bxCAN acceptance filters, so
+ * only the Blackbody frames raise the RX interrupt. The ISR stamps each
+ * frame with the attached clock and the device time and pushes it into a
+ * second ring for a consumer thread; overflows are counted. Frames with
+ * the sync ID skip the ring and go straight to the sync handler, so the
+ * time they were stamped at is not held up behind sensor traffic. This goes through the mbed C
+ * CAN HAL rather than the CAN driver class, whose mutex cannot be taken
+ * from an ISR.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "hal/can_api.h"
+#include "Diagnostics/DeviceClock.hpp"
+#include "Pipeline/SpscRing.hpp"
+
+/** A received frame and the clock tick and device time it arrived at. */
+struct CanFrame {
+    CAN_Message msg;
+    uint32_t tick;
+    uint64_t timeUs;
+};
+
+class CanLink {
+    public:
+        /** Frames the TX ring holds on top of the three mailboxes. */
+        static const uint16_t TX_DEPTH = 32;
+        /** Received frames held for the consumer. */
+        static const uint16_t RX_DEPTH = 32;
+        /** Acceptance filter banks of the bxCAN controller. */
+        static const uint8_t MAX_FILTERS = 14;
+
+        CanLink(PinName rd, PinName td);
+
+        /**
+         * @brief Bring up the controller at the given bit rate and arm the
+         * TX interrupt.
+         *
+         * @return false The controller did not leave initialization in
+         * time, e.g. with no transceiver on the pins.
+         */
+        bool start(uint32_t hz);
+
+        /**
+         * @brief Queue a standard data frame without blocking, from any
+         * thread.
+         *
+         * @return false The ring is full; the frame is dropped and counted.
+         */
+        bool post(uint16_t id, const uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Accept only the given standard IDs, one filter bank each,
+         * and arm the RX interrupt.
+         *
+         * @return false Too many IDs, or a filter could not be set.
+         */
+        bool accept(const uint16_t *ids, uint8_t numIds);
+
+        /** Timestamp received frames with clock, called from the RX ISR. */
+        void attachClock(Callback<uint32_t(void)> clock);
+
+        /** Hand frames with the given ID to handler, from the RX ISR. */
+        void attachSync(uint16_t id, Callback<void(const CanFrame &frame)> handler);
+
+        /** Take the oldest received frame. Call from one thread only. */
+        bool receive(CanFrame *frame) { return rxRing.pop(frame); }
+
+        /** Nothing is queued or waiting in a mailbox. */
+        bool isIdle(void) const { return txRing.empty() && (CAN1->TSR & CAN_TSR_TME) == CAN_TSR_TME; }
+
+        /** Frames handed to a mailbox. */
+        uint32_t getSent(void) const { return sent; }
+
+        /** Frames dropped on a full ring. */
+        uint32_t getDropped(void) const { return dropped; }
+
+        /** Received frames dropped on a full ring. */
+        uint32_t getRxDropped(void) const { return rxDropped; }
+
+    private:
+        static void irqHandler(uintptr_t context, CanIrqType type);
+
+        /** Move queued frames into free mailboxes. Runs with IRQs masked. */
+        void pump(void);
+
+        /** Drain the RX FIFO into the ring. Runs in the RX ISR. */
+        void drain(void);
+
+        PinName rd;
+        PinName td;
+        can_t can;
+        SpscRing<CAN_Message, TX_DEPTH> txRing;
+        SpscRing<CanFrame, RX_DEPTH> rxRing;
+        Callback<uint32_t(void)> clock;
+        uint16_t syncId;
+        Callback<void(const CanFrame &frame)> onSync;
+        volatile uint32_t sent;
+        volatile uint32_t dropped;
+        volatile uint32_t rxDropped;
+};
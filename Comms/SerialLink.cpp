@@ -0,0 +1,235 @@
+/**
+ * @file SerialLink.cpp
+ * @brief USB USART link to the PC.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "SerialLink.hpp"
+#include "Protocol/Frame.hpp"
+
+#define ACCEPT_TIMEOUT  200ms
+#define SPACE_TIMEOUT   100ms
+#define DRAIN_TIME      5ms
+#define FLAG_SPACE      0x1
+#define FLAG_ACCEPT     0x2
+
+SerialLink *SerialLink::instance = nullptr;
+
+SerialLink::SerialLink(PinName tx, PinName rx, uint32_t baud) :
+    serial(tx, rx, baud),
+    baud(baud),
+    hdma(),
+    accepted(0),
+    buffer(),
+    reserved(0),
+    head(0),
+    tail(0),
+    wrap(TX_SIZE),
+    sending(0),
+    waits(0),
+    timeouts(0) {
+    serial.format(
+        8,                      /* bits */
+        SerialBase::None,       /* parity */
+        1                       /* stop bit */
+    );
+    serial.attach(callback(this, &SerialLink::onRx), SerialBase::RxIrq);
+
+    /* DMA1 channel 7, request 2 is USART2_TX. */
+    instance = this;
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma.Instance = DMA1_Channel7;
+    hdma.Init.Request = DMA_REQUEST_2;
+    hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma.Init.MemInc = DMA_MINC_ENABLE;
+    hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma.Init.Mode = DMA_NORMAL;
+    hdma.Init.Priority = DMA_PRIORITY_LOW;
+    HAL_DMA_Init(&hdma);
+    DMA1_Channel7->CPAR = (uint32_t)&USART2->TDR;
+    DMA1_Channel7->CCR |= DMA_CCR_TCIE;
+
+    NVIC_SetVector(DMA1_Channel7_IRQn, (uint32_t)&SerialLink::dmaIrqHandler);
+    HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+}
+
+uint32_t SerialLink::negotiate(const uint32_t *rates, uint8_t numRates) {
+    for (uint8_t r = 0; r < numRates; ++r) {
+        if (rates[r] <= baud) break;
+
+        accepted = 0;
+        flags.clear(FLAG_ACCEPT);
+        uint8_t *frame = reserve(Frame::LINK_SIZE);
+        if (frame == nullptr) break;
+        Frame::encodeLink(frame, ID_LINK_OFFER, rates[r]);
+        commit(Frame::LINK_SIZE);
+
+        /* The RX ISR posts any accept; only an echo of this offer counts. */
+        Timer timer;
+        timer.start();
+        while (timer.elapsed_time() < ACCEPT_TIMEOUT) {
+            uint32_t result = flags.wait_any_for(FLAG_ACCEPT, ACCEPT_TIMEOUT);
+            if (result & osFlagsError) break;
+            if (accepted != rates[r]) continue;
+
+            /* Let the UART drain before retiming it. */
+            drain();
+            ThisThread::sleep_for(DRAIN_TIME);
+            serial.baud(rates[r]);
+            baud = rates[r];
+            return baud;
+        }
+    }
+    return baud;
+}
+
+void SerialLink::attach(Callback<void(const uint8_t *frame, uint16_t msgId)> handler) {
+    core_util_critical_section_enter();
+    this->handler = handler;
+    core_util_critical_section_exit();
+}
+
+uint8_t *SerialLink::reserve(uint16_t len) {
+    if (len == 0 || len >= TX_SIZE) return nullptr;
+    lock.lock();
+
+    bool waited = false;
+    while (1) {
+        core_util_critical_section_enter();
+        uint16_t h = head;
+        uint16_t t = tail;
+        core_util_critical_section_exit();
+
+        /* Keep head != tail unless empty; full and empty must differ. */
+        if (h >= t && TX_SIZE - h >= len) {
+            reserved = h;
+            return &buffer[h];
+        }
+        if (h >= t && t > len) {
+            reserved = 0;
+            return &buffer[0];
+        }
+        if (h < t && t - h > len) {
+            reserved = h;
+            return &buffer[h];
+        }
+
+        if (!waited) {
+            waited = true;
+            ++waits;
+        }
+        uint32_t result = flags.wait_any_for(FLAG_SPACE, SPACE_TIMEOUT);
+        if (result & osFlagsError) {
+            ++timeouts;
+            lock.unlock();
+            return nullptr;
+        }
+    }
+}
+
+void SerialLink::commit(uint16_t len) {
+    core_util_critical_section_enter();
+    if (reserved != head) {
+        /* The record went to the start; skip what is left at the end. */
+        wrap = head;
+    }
+    head = reserved + len;
+    kick();
+    core_util_critical_section_exit();
+    lock.unlock();
+}
+
+void SerialLink::drain(void) {
+    while (1) {
+        core_util_critical_section_enter();
+        bool idle = sending == 0 && head == tail;
+        core_util_critical_section_exit();
+        if (idle) break;
+        flags.wait_any_for(FLAG_SPACE, SPACE_TIMEOUT);
+    }
+    /* The last byte is still shifting out when the DMA completes. */
+    while ((USART2->ISR & USART_ISR_TC) == 0) {}
+}
+
+void SerialLink::suspend(void) {
+    serial.attach(nullptr, SerialBase::RxIrq);
+}
+
+void SerialLink::resume(void) {
+    parser.reset();
+    serial.attach(callback(this, &SerialLink::onRx), SerialBase::RxIrq);
+}
+
+ssize_t SerialLink::write(const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t written = 0;
+    while (written < size) {
+        uint16_t chunk = size - written > TX_SIZE / 4 ? TX_SIZE / 4 : size - written;
+        uint8_t *out = reserve(chunk);
+        if (out == nullptr) break;
+        memcpy(out, bytes + written, chunk);
+        commit(chunk);
+        written += chunk;
+    }
+    return written;
+}
+
+ssize_t SerialLink::read(void *data, size_t size) {
+    /* All input is consumed by the frame parser. */
+    return -EAGAIN;
+}
+
+void SerialLink::onRx(void) {
+    while (serial.readable()) {
+        uint8_t byte;
+        if (serial.read(&byte, 1) != 1) break;
+        if (!parser.feed(byte)) continue;
+
+        if (parser.id() == ID_LINK_ACCEPT) {
+            uint32_t rate;
+            if (Frame::decodeLink(parser.data(), ID_LINK_ACCEPT, &rate)) {
+                accepted = rate;
+                flags.set(FLAG_ACCEPT);
+            }
+        } else if (handler) {
+            handler(parser.data(), parser.id());
+        }
+    }
+}
+
+void SerialLink::kick(void) {
+    if (sending != 0) return;
+
+    /* Passed the skipped end of the ring: continue from the start. */
+    if (head < tail && tail == wrap) {
+        tail = 0;
+        wrap = TX_SIZE;
+    }
+    uint16_t end = head >= tail ? head : wrap;
+    if (end == tail) return;
+
+    sending = end - tail;
+    DMA1_Channel7->CCR &= ~DMA_CCR_EN;
+    DMA1_Channel7->CMAR = (uint32_t)&buffer[tail];
+    DMA1_Channel7->CNDTR = sending;
+    /* baud() reinitializes the UART, clearing DMAT. */
+    USART2->CR3 |= USART_CR3_DMAT;
+    DMA1_Channel7->CCR |= DMA_CCR_EN;
+}
+
+void SerialLink::dmaIrqHandler(void) {
+    if (DMA1->ISR & DMA_ISR_TCIF7) {
+        DMA1->IFCR = DMA_IFCR_CTCIF7;
+        if (instance) {
+            instance->tail = instance->tail + instance->sending;
+            instance->sending = 0;
+            instance->kick();
+            instance->flags.set(FLAG_SPACE);
+        }
+    }
+}
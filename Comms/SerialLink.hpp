@@ -0,0 +1,127 @@
+/**
+ * @file SerialLink.hpp
+ * @brief USB USART link to the PC. Owns the UART shared with stdio and
+ * negotiates a faster baud rate with the host at startup.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Output goes through a byte ring drained by DMA1 channel 7 (USART2_TX)
+ * in the background. Frames are encoded straight into the ring: reserve()
+ * returns contiguous space, the caller writes the record in place and
+ * commit() publishes it, starting the DMA if it is idle. A record never
+ * straddles the end of the ring; when it does not fit, it goes to the
+ * start and the tail of the ring is skipped, so every DMA transfer is a
+ * single contiguous run. stdio writes copy into the ring the same way,
+ * so printf only blocks while the ring is full. DMA1 channel 7 is
+ * otherwise unused by mbed on this target.
+ *
+ * Input is parsed a byte at a time in the RX interrupt. Link accepts are
+ * consumed by negotiate(); every other complete frame is handed to the
+ * attached handler, still in the ISR.
+ */
+
+#pragma once
+#include <errno.h>
+#include "mbed.h"
+#include "Protocol/FrameParser.hpp"
+
+class SerialLink : public FileHandle {
+    public:
+        /** Bytes buffered for transmission. */
+        static const uint16_t TX_SIZE = 2048;
+
+        SerialLink(PinName tx, PinName rx, uint32_t baud);
+
+        /**
+         * @brief Offer each rate in turn, fastest first, and switch to the
+         * first one the host accepts. The link stays at the current rate
+         * if no offer is accepted within the timeout.
+         *
+         * @param rates Candidate baud rates, fastest first.
+         * @param numRates Number of candidates.
+         * @return uint32_t The baud rate in use afterwards.
+         */
+        uint32_t negotiate(const uint32_t *rates, uint8_t numRates);
+
+        /**
+         * @brief Reserve len contiguous bytes of the TX ring, waiting for
+         * the DMA to free space if needed. Every successful reserve()
+         * must be followed by one commit() from the same thread.
+         *
+         * @return uint8_t* Where to encode the record, or nullptr if space
+         * did not free up in time.
+         */
+        uint8_t *reserve(uint16_t len);
+
+        /** Queue the first len bytes of the last reservation for sending. */
+        void commit(uint16_t len);
+
+        /**
+         * @brief Call handler from the RX ISR with each complete frame
+         * other than a link accept. Pass nullptr to detach.
+         */
+        void attach(Callback<void(const uint8_t *frame, uint16_t msgId)> handler);
+
+        /** Wait until everything committed has left the UART. */
+        void drain(void);
+
+        /**
+         * @brief Stop listening, releasing the deep sleep lock the RX
+         * interrupt holds. Bytes arriving meanwhile are lost.
+         */
+        void suspend(void);
+
+        /** Listen again, from a fresh frame. May be called from an ISR. */
+        void resume(void);
+
+        /** Stream to retarget stdio to, so printf shares the ring. */
+        FileHandle *getStream(void) { return this; }
+
+        uint32_t getBaud(void) const { return baud; }
+
+        /** Reservations that found the ring full and waited for the DMA. */
+        uint32_t getWaits(void) const { return waits; }
+
+        /** Reservations given up because space did not free up in time. */
+        uint32_t getTimeouts(void) const { return timeouts; }
+
+        /** FileHandle, for stdio. */
+        ssize_t write(const void *buffer, size_t size) override;
+        ssize_t read(void *buffer, size_t size) override;
+        off_t seek(off_t offset, int whence) override { return -ESPIPE; }
+        int close(void) override { return 0; }
+        int sync(void) override { drain(); return 0; }
+        int isatty(void) override { return 1; }
+
+    private:
+        static void dmaIrqHandler(void);
+        void onRx(void);
+        /** Start the next contiguous run if the DMA is idle. IRQs masked. */
+        void kick(void);
+
+        static SerialLink *instance;
+
+        UnbufferedSerial serial;
+        uint32_t baud;
+        DMA_HandleTypeDef hdma;
+        EventFlags flags;
+        Mutex lock;
+
+        /* RX ISR state. */
+        FrameParser parser;
+        Callback<void(const uint8_t *, uint16_t)> handler;
+        volatile uint32_t accepted;
+
+        uint8_t buffer[TX_SIZE];
+        /* Producer side, under lock. */
+        uint16_t reserved;
+        /* Shared with the DMA ISR, updated with IRQs masked. */
+        volatile uint16_t head;
+        volatile uint16_t tail;
+        volatile uint16_t wrap;
+        volatile uint16_t sending;
+        /* Producer side, under lock. */
+        uint32_t waits;
+        uint32_t timeouts;
+};
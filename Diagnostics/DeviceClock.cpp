@@ -0,0 +1,27 @@
+/**
+ * @file DeviceClock.cpp
+ * @brief Device time in microseconds since boot, from the hardware us
+ * ticker, for stamping points, passes and received frames.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "DeviceClock.hpp"
+
+uint64_t DeviceClock::offset = 0;
+
+uint64_t DeviceClock::now(void) {
+    /* The offset is 64 bits; read it with the ticker in one go. */
+    core_util_critical_section_enter();
+    uint64_t us = ticker_read_us(get_us_ticker_data()) + offset;
+    core_util_critical_section_exit();
+    return us;
+}
+
+void DeviceClock::catchUp(uint64_t since, uint64_t sleptUs) {
+    core_util_critical_section_enter();
+    uint64_t counted = ticker_read_us(get_us_ticker_data()) + offset - since;
+    if (sleptUs > counted) offset += sleptUs - counted;
+    core_util_critical_section_exit();
+}
@@ -0,0 +1,35 @@
+/**
+ * @file DeviceClock.hpp
+ * @brief Device time in microseconds since boot, from the hardware us
+ * ticker, for stamping points, passes and received frames.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * mbed runs its us ticker from a free running 32-bit timer (TIM2 on the
+ * L432) at 1 MHz and extends it to 64 bits, so the time never wraps and
+ * can be read from any context. The timer stands still in Stop 2; after
+ * a sleep, catchUp() adds what the low power timer saw pass on top of
+ * what the ticker counted, to within the LPTIM resolution. The host maps
+ * device time to wall time with the sync exchange (see the README).
+ */
+
+#pragma once
+#include "mbed.h"
+#include "hal/ticker_api.h"
+#include "hal/us_ticker_api.h"
+
+class DeviceClock {
+    public:
+        /** Microseconds since boot. */
+        static uint64_t now(void);
+
+        /**
+         * @brief Account for a sleep that started at now() == since and
+         * lasted sleptUs by the low power timer.
+         */
+        static void catchUp(uint64_t since, uint64_t sleptUs);
+
+    private:
+        static uint64_t offset;     /* Time the ticker missed in Stop 2, us. */
+};
@@ -0,0 +1,85 @@
+/**
+ * @file FaultMonitor.cpp
+ * @brief Fault codes, the latest pending fault and the hardware watchdog
+ * that backs them up.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "FaultMonitor.hpp"
+#include "DeviceClock.hpp"
+
+FaultMonitor::FaultMonitor(uint32_t timeoutMs, uint32_t deadlineMs) :
+    kicker(),
+    timeoutMs(timeoutMs),
+    deadlineUs((uint64_t)deadlineMs * 1000),
+    pending(FAULT_NONE),
+    pendingContext(0),
+    faults(0) {
+    for (uint8_t t = 0; t < NUM_TASKS; ++t) {
+        working[t] = false;
+        seenUs[t] = 0;
+    }
+}
+
+bool FaultMonitor::start(void) {
+    Watchdog &watchdog = Watchdog::get_instance();
+    uint32_t timeout = timeoutMs > watchdog.get_max_timeout() ? watchdog.get_max_timeout() : timeoutMs;
+    if (!watchdog.start(timeout)) return false;
+
+    /* Four kicks per timeout, so one late tick is not a reset. */
+    kicker.attach(callback(this, &FaultMonitor::onTick), std::chrono::milliseconds(timeout / 4));
+    return true;
+}
+
+bool FaultMonitor::wasWatchdogReset(void) {
+    return ResetReason::get() == RESET_REASON_WATCHDOG;
+}
+
+void FaultMonitor::busy(enum Task task) {
+    core_util_critical_section_enter();
+    seenUs[task] = DeviceClock::now();
+    working[task] = true;
+    core_util_critical_section_exit();
+}
+
+void FaultMonitor::checkIn(enum Task task) {
+    uint64_t now = DeviceClock::now();
+    core_util_critical_section_enter();
+    seenUs[task] = now;
+    core_util_critical_section_exit();
+}
+
+void FaultMonitor::idle(enum Task task) {
+    working[task] = false;
+}
+
+void FaultMonitor::raise(enum FaultCode code, uint16_t context) {
+    core_util_critical_section_enter();
+    if (pending == FAULT_NONE) {
+        pending = code;
+        pendingContext = context;
+    }
+    faults = faults + 1;
+    core_util_critical_section_exit();
+}
+
+bool FaultMonitor::take(enum FaultCode *code, uint16_t *context) {
+    core_util_critical_section_enter();
+    bool taken = pending != FAULT_NONE;
+    *code = (enum FaultCode)pending;
+    *context = pendingContext;
+    pending = FAULT_NONE;
+    core_util_critical_section_exit();
+    return taken;
+}
+
+void FaultMonitor::onTick(void) {
+    uint64_t now = DeviceClock::now();
+    for (uint8_t t = 0; t < NUM_TASKS; ++t) {
+        /* A stuck task stops the kicks; the watchdog does the rest. */
+        if (working[t] && now - seenUs[t] > deadlineUs) return;
+    }
+    Watchdog::get_instance().kick();
+}
@@ -0,0 +1,98 @@
+/**
+ * @file FaultMonitor.hpp
+ * @brief Fault codes, the latest pending fault and the hardware watchdog
+ * that backs them up.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Faults the firmware can see, such as an acquisition block that does
+ * not arrive, are raised from wherever they are found. The sweep loop
+ * notices the pending fault, abandons the pass, reports it to the host
+ * and restarts acquisition, so the profile can run again a few ms later.
+ *
+ * Faults it cannot see, such as a thread that never returns, are left to
+ * the independent watchdog (IWDG), which resets the MCU. A low power
+ * ticker kicks it, so it is also kicked in Stop 2, where the IWDG keeps
+ * running, but only while every task marked busy has checked in within
+ * its deadline. The watchdog cannot be stopped once started.
+ */
+
+#pragma once
+#include "mbed.h"
+
+/** Context-free fault codes, sent in exception frames with ID_FAULT. */
+enum FaultCode {
+    FAULT_NONE,
+    FAULT_ADC_STALL,            /* No acquisition block or sequenced point in time. */
+    FAULT_ADC_RESTART,          /* Acquisition could not be started or restarted. */
+    FAULT_CAN_START,            /* The CAN controller or its filters could not be set up. */
+    FAULT_SLEEP,                /* Stop 2 could not be armed. */
+    FAULT_BAD_REGIME,           /* A profile with no sweep for its regime. */
+    FAULT_PROFILE_DROPPED,      /* A profile kept faulting and was given up; context is its ID. */
+    FAULT_WATCHDOG_RESET,       /* At boot: the watchdog reset the MCU. */
+    FAULT_WATCHDOG_START,       /* At boot: the watchdog could not be started. */
+    NUM_FAULTS
+};
+
+/** Threads supervised by the watchdog. */
+enum Task {
+    TASK_SWEEP,
+    TASK_TRANSMIT,
+    NUM_TASKS
+};
+
+class FaultMonitor {
+    public:
+        /**
+         * @param timeoutMs Watchdog timeout.
+         * @param deadlineMs Longest a busy task may go without checking in.
+         */
+        FaultMonitor(uint32_t timeoutMs, uint32_t deadlineMs);
+
+        /**
+         * @brief Start the watchdog and its kicker; once, at boot.
+         *
+         * @return false The watchdog could not be started.
+         */
+        bool start(void);
+
+        /** The watchdog reset the MCU before this boot. */
+        static bool wasWatchdogReset(void);
+
+        /** A task starts work during which it checks in. */
+        void busy(enum Task task);
+
+        /** A busy task is still making progress. */
+        void checkIn(enum Task task);
+
+        /** A task blocks on something with no deadline, e.g. the host. */
+        void idle(enum Task task);
+
+        /**
+         * @brief Raise a fault from any context. The first one raised
+         * stays pending until taken; later ones are only counted.
+         */
+        void raise(enum FaultCode code, uint16_t context);
+
+        /** A fault is waiting to be handled. */
+        bool isPending(void) const { return pending != FAULT_NONE; }
+
+        /** @return false Nothing is pending. */
+        bool take(enum FaultCode *code, uint16_t *context);
+
+        /** Faults raised since boot. */
+        uint32_t getFaults(void) const { return faults; }
+
+    private:
+        void onTick(void);
+
+        LowPowerTicker kicker;
+        uint32_t timeoutMs;
+        uint64_t deadlineUs;
+        volatile bool working[NUM_TASKS];
+        volatile uint64_t seenUs[NUM_TASKS];   /* Device time of the last check in. */
+        volatile uint8_t pending;
+        volatile uint16_t pendingContext;
+        volatile uint32_t faults;
+};
@@ -0,0 +1,90 @@
+/**
+ * @file StageStats.hpp
+ * @brief Cycle counts of each stage of the scan loop, from the DWT cycle
+ * counter.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * A stage is timed by taking now() before and after it and adding the
+ * difference; the counter wraps every 53 s at 80 MHz, far beyond any
+ * stage. Each instance keeps the min, mean and max of every stage over
+ * one sweep pass and must only be updated from one thread; the sweep and
+ * transmit threads keep their own and merge() them once per pass.
+ */
+
+#pragma once
+#include "mbed.h"
+
+enum Stage {
+    STAGE_DAC,                  /* DAC write. */
+    STAGE_SETTLE,               /* Waiting for the readings to settle. */
+    STAGE_SAMPLE,               /* Accumulating the blocks of a point. */
+    STAGE_CALIBRATE,            /* Calibration and curve extraction. */
+    STAGE_EMIT,                 /* Encoding and queueing the output. */
+    NUM_STAGES
+};
+
+struct StageTiming {
+    uint32_t min;               /* Cycles. */
+    uint32_t max;
+    uint64_t sum;
+    uint32_t count;
+};
+
+class StageStats {
+    public:
+        StageStats(void) { reset(); }
+
+        /** Start the cycle counter; once at boot. */
+        static void enableCounter(void) {
+            CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+            DWT->CYCCNT = 0;
+            DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        }
+
+        static uint32_t now(void) { return DWT->CYCCNT; }
+
+        void reset(void) {
+            for (uint8_t s = 0; s < NUM_STAGES; ++s) {
+                stages[s].min = UINT32_MAX;
+                stages[s].max = 0;
+                stages[s].sum = 0;
+                stages[s].count = 0;
+            }
+        }
+
+        /** Account a stage that started at now() == since. */
+        void add(enum Stage stage, uint32_t since) {
+            uint32_t cycles = now() - since;
+            StageTiming &timing = stages[stage];
+            if (cycles < timing.min) timing.min = cycles;
+            if (cycles > timing.max) timing.max = cycles;
+            timing.sum += cycles;
+            ++timing.count;
+        }
+
+        /** Take over the stages timed in other. */
+        void merge(const StageStats &other) {
+            for (uint8_t s = 0; s < NUM_STAGES; ++s) {
+                if (other.stages[s].count != 0) stages[s] = other.stages[s];
+            }
+        }
+
+        const StageTiming &get(enum Stage stage) const { return stages[stage]; }
+
+        /** Min, mean and max of a stage in cycles; all 0 if never timed. */
+        void summarize(enum Stage stage, uint32_t *min, uint32_t *mean, uint32_t *max) const {
+            const StageTiming &timing = stages[stage];
+            if (timing.count == 0) {
+                *min = *mean = *max = 0;
+                return;
+            }
+            *min = timing.min;
+            *mean = (uint32_t)(timing.sum / timing.count);
+            *max = timing.max;
+        }
+
+    private:
+        StageTiming stages[NUM_STAGES];
+};
@@ -0,0 +1,41 @@
+/**
+ * @file Point.hpp
+ * @brief One measured sweep point, before calibration and encoding.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+#include <stdint.h>
+
+struct Point {
+    uint16_t sampleId;
+    uint16_t dacCode;
+    uint16_t volt;              /* Mean raw voltage code, Q12.4. */
+    uint16_t curr;              /* Mean raw current code, Q12.4. */
+    uint32_t settleUs;          /* Settle time used before sampling. */
+    uint8_t voltNoise;          /* RMS voltage noise, Q12.4 codes, saturating. */
+    uint8_t currNoise;          /* RMS current noise, Q12.4 codes, saturating. */
+    uint8_t mode;
+    uint8_t channel;            /* Tracer channel, 0 unless several are swept. */
+    bool reverse;               /* Swept from the last code of the table to the first. */
+    uint32_t tick;              /* Acquisition block count when sampling ended. */
+    uint32_t timeUs;            /* Device time when sampling ended, low 32 bits. */
+};
+
+/** Sums and sums of squares of the raw codes of a point. */
+struct Moments {
+    uint32_t voltSum;
+    uint32_t currSum;
+    uint64_t voltSq;
+    uint64_t currSq;
+};
+
+/** Raw sums of one sequenced step, as produced in the sequencer ISR. */
+struct RawPoint {
+    uint16_t index;             /* Step of the pass. */
+    Moments sums;
+    uint32_t tick;              /* Acquisition block count when sampling ended. */
+    uint32_t timeUs;            /* Device time when sampling ended, low 32 bits. */
+};
@@ -0,0 +1,124 @@
+/**
+ * @file PointPipeline.hpp
+ * @brief Ping-pong hand-off of measured points from the sweep thread to
+ * the transmit thread.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Two point batches circulate between the stages. The sweep fills one
+ * while the transmitter drains the other; batches travel through
+ * lock-free SPSC rings and the semaphores only park whichever side has
+ * nothing to do. The sweep blocks only if the transmitter is a whole
+ * batch behind.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "Point.hpp"
+#include "SpscRing.hpp"
+
+struct PointBatch {
+    static const uint16_t SIZE = 16;
+    uint16_t count;
+    bool last;                  /* Final batch of a sweep pass. */
+    bool done;                  /* Empty batch marking the end of a profile. */
+    uint16_t profileId;         /* Profile ended, when done. */
+    uint64_t startUs;           /* Device time the pass started. */
+    Point points[SIZE];
+};
+
+class PointPipeline {
+    public:
+        PointPipeline(void) :
+            filling(nullptr),
+            startUs(0),
+            filledCount(0, 2),
+            freeCount(2, 2) {
+            freeRing.push(&batches[0]);
+            freeRing.push(&batches[1]);
+        }
+
+        /** Sweep side: start a pass at device time startUs. */
+        void begin(uint64_t startUs) {
+            this->startUs = startUs;
+            if (filling != nullptr) filling->startUs = startUs;
+        }
+
+        /** Sweep side: append a point, handing the batch over when full. */
+        void push(const Point &point) {
+            if (filling == nullptr) take();
+            filling->points[filling->count++] = point;
+            if (filling->count == PointBatch::SIZE) hand();
+        }
+
+        /**
+         * Sweep side: end the sweep pass, handing over the batch being
+         * filled, or an empty one, marked as the last.
+         */
+        void flush(void) {
+            if (filling == nullptr) take();
+            filling->last = true;
+            hand();
+        }
+
+        /**
+         * Sweep side: after the last pass of a profile, hand over an
+         * empty batch marking it done.
+         */
+        void finish(uint16_t profileId) {
+            if (filling == nullptr) take();
+            filling->done = true;
+            filling->profileId = profileId;
+            hand();
+        }
+
+        /**
+         * Sweep side, between passes: wait until the transmit side is
+         * done with every batch handed over.
+         */
+        void drain(void) {
+            freeCount.acquire();
+            freeCount.acquire();
+            freeCount.release();
+            freeCount.release();
+        }
+
+        /** Transmit side: sleep until a batch is ready. */
+        PointBatch *wait(void) {
+            PointBatch *batch;
+            filledCount.acquire();
+            filledRing.pop(&batch);
+            return batch;
+        }
+
+        /** Transmit side: give a drained batch back to the sweep. */
+        void release(PointBatch *batch) {
+            freeRing.push(batch);
+            freeCount.release();
+        }
+
+    private:
+        void take(void) {
+            freeCount.acquire();
+            freeRing.pop(&filling);
+            filling->count = 0;
+            filling->last = false;
+            filling->done = false;
+            filling->startUs = startUs;
+        }
+
+        void hand(void) {
+            filledRing.push(filling);
+            filling = nullptr;
+            filledCount.release();
+        }
+
+        PointBatch batches[2];
+        PointBatch *filling;
+        uint64_t startUs;
+        SpscRing<PointBatch *, 2> filledRing;
+        SpscRing<PointBatch *, 2> freeRing;
+        Semaphore filledCount;
+        Semaphore freeCount;
+};
@@ -0,0 +1,159 @@
+/**
+ * @file ResultStore.hpp
+ * @brief The last few sweep passes, packed in SRAM for the PC to read
+ * back in bulk.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Points are packed to 8 bytes and appended to one ring shared by all
+ * passes, so a short pass takes little room and the oldest passes give
+ * way as new ones arrive. Positions are free running; a pass is still
+ * whole while the write position is less than CAPACITY past its first
+ * point. The transmit thread writes and never waits. A reader pins the
+ * pass it copies out; if a new pass would overwrite it, the new pass is
+ * cut short instead and counted as an overrun.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "Point.hpp"
+#include "Protocol/Frame.hpp"
+
+struct PackedPoint {
+    uint16_t dacCode;           /* Channel in bits 15:12, DAC code in 11:0. */
+    uint16_t volt;              /* Mean raw voltage code, Q12.4. */
+    uint16_t curr;              /* Mean raw current code, Q12.4. */
+    uint8_t settle;             /* Frame::SETTLE_UNIT_US, saturating. */
+    uint8_t noise;              /* Larger of the RMS noise of both channels. */
+};
+static_assert(sizeof(PackedPoint) == 8, "PackedPoint must stay packed.");
+
+struct SweepRecord {
+    uint16_t sweepId;
+    uint8_t mode;
+    bool complete;              /* Every point of the pass is stored. */
+    uint32_t first;             /* Position of the first point. */
+    uint16_t count;
+};
+
+class ResultStore {
+    public:
+        /** Points stored, 16 kB. */
+        static const uint16_t CAPACITY = 2048;
+        /** Passes indexed, a power of two. */
+        static const uint8_t MAX_SWEEPS = 8;
+        /** Sweep ID matching the latest whole pass. */
+        static const uint16_t ANY_SWEEP = 0xFFFF;
+
+        ResultStore(void) :
+            records(),
+            opened(0),
+            open(false),
+            head(0),
+            pinned(false),
+            pinFirst(0),
+            overruns(0) {}
+
+        /** Writer: start storing a new pass. */
+        void begin(uint16_t sweepId, uint8_t mode) {
+            core_util_critical_section_enter();
+            SweepRecord &record = records[opened & (MAX_SWEEPS - 1)];
+            record.sweepId = sweepId;
+            record.mode = mode;
+            record.complete = false;
+            record.first = head;
+            record.count = 0;
+            open = true;
+            core_util_critical_section_exit();
+        }
+
+        /** Writer: append a point to the open pass; never blocks. */
+        void append(const Point &point) {
+            if (!open) return;
+            uint32_t settle = point.settleUs / Frame::SETTLE_UNIT_US;
+            PackedPoint packed = {
+                (uint16_t)((point.channel << 12) | (point.dacCode & 0xFFF)),
+                point.volt,
+                point.curr,
+                (uint8_t)(settle > 0xFF ? 0xFF : settle),
+                point.voltNoise > point.currNoise ? point.voltNoise : point.currNoise
+            };
+
+            core_util_critical_section_enter();
+            SweepRecord &record = records[opened & (MAX_SWEEPS - 1)];
+            if ((pinned && head - pinFirst >= CAPACITY) || record.count == CAPACITY) {
+                /* Would overwrite the pass being read, or itself. */
+                open = false;
+                ++opened;
+                ++overruns;
+            } else {
+                points[head & (CAPACITY - 1)] = packed;
+                ++head;
+                ++record.count;
+            }
+            core_util_critical_section_exit();
+        }
+
+        /** Writer: the open pass has all its points. */
+        void end(void) {
+            core_util_critical_section_enter();
+            if (open) {
+                records[opened & (MAX_SWEEPS - 1)].complete = true;
+                open = false;
+                ++opened;
+            }
+            core_util_critical_section_exit();
+        }
+
+        /**
+         * @brief Reader: find a pass that is still whole and keep it from
+         * being overwritten until unpin().
+         *
+         * @param sweepId The pass to find, or ANY_SWEEP for the latest.
+         * @return false No such pass is stored.
+         */
+        bool pin(uint16_t sweepId, SweepRecord *record) {
+            bool found = false;
+            core_util_critical_section_enter();
+            for (uint8_t k = 1; k <= MAX_SWEEPS && k <= opened; ++k) {
+                const SweepRecord &candidate = records[(opened - k) & (MAX_SWEEPS - 1)];
+                if (!candidate.complete) continue;
+                /* Partly overwritten, and so is everything older. */
+                if (head - candidate.first >= CAPACITY) break;
+                if (sweepId != ANY_SWEEP && candidate.sweepId != sweepId) continue;
+                *record = candidate;
+                pinned = true;
+                pinFirst = candidate.first;
+                found = true;
+                break;
+            }
+            core_util_critical_section_exit();
+            return found;
+        }
+
+        void unpin(void) {
+            core_util_critical_section_enter();
+            pinned = false;
+            core_util_critical_section_exit();
+        }
+
+        /** Reader: a point of the pinned pass. */
+        const PackedPoint &at(const SweepRecord &record, uint16_t index) const {
+            return points[(record.first + index) & (CAPACITY - 1)];
+        }
+
+        /** Passes cut short to keep a pinned one. */
+        uint32_t getOverruns(void) const { return overruns; }
+
+    private:
+        PackedPoint points[CAPACITY];
+        SweepRecord records[MAX_SWEEPS];
+        /* Writer side, shared with the reader with IRQs masked. */
+        uint32_t opened;            /* Passes closed; indexes the open one. */
+        bool open;
+        uint32_t head;
+        bool pinned;
+        uint32_t pinFirst;
+        uint32_t overruns;
+};
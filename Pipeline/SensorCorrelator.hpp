@@ -0,0 +1,93 @@
+/**
+ * @file SensorCorrelator.hpp
+ * @brief Tags Blackbody sensor frames with the sample ID of the sweep
+ * point closest to them in time.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Frames and points are both stamped with the acquisition block count,
+ * frames in the CAN RX ISR and points when their sampling ends. Points
+ * are fed in sweep order from the transmit thread; a frame is tagged once
+ * the first point at or after it is known, with whichever of that point
+ * and the one before it is nearer. Frames further than the window from
+ * either point (e.g. received between profiles) are dropped as stale.
+ */
+
+#pragma once
+#include "mbed.h"
+#include "Comms/CanLink.hpp"
+#include "Point.hpp"
+
+class SensorCorrelator {
+    public:
+        typedef Callback<void(const CanFrame &frame, uint16_t sampleId)> Handler;
+
+        /** @param window Largest distance to a point, in blocks. */
+        SensorCorrelator(CanLink &link, uint32_t window) :
+            link(link),
+            window(window),
+            pending(),
+            hasPending(false),
+            hasLast(false),
+            lastId(0),
+            lastTick(0),
+            stale(0) {}
+
+        /** Tag and hand over every frame received up to point. */
+        void update(const Point &point, Handler handler) {
+            while (next()) {
+                /* Later than this point; the next one may be nearer. */
+                if ((int32_t)(pending.tick - point.tick) > 0) return;
+
+                uint32_t toPoint = point.tick - pending.tick;
+                if (hasLast && (int32_t)(pending.tick - lastTick) >= 0 && pending.tick - lastTick < toPoint) {
+                    emit(lastId, pending.tick - lastTick, handler);
+                } else {
+                    emit(point.sampleId, toPoint, handler);
+                }
+            }
+            hasLast = true;
+            lastId = point.sampleId;
+            lastTick = point.tick;
+        }
+
+        /** End of a pass: tag what is left with the last point. */
+        void finish(Handler handler) {
+            while (next()) {
+                if (hasLast && (int32_t)(pending.tick - lastTick) >= 0) {
+                    emit(lastId, pending.tick - lastTick, handler);
+                } else {
+                    emit(0, window + 1, handler);
+                }
+            }
+            hasLast = false;
+        }
+
+        /** Frames dropped for being outside the window. */
+        uint32_t getStale(void) const { return stale; }
+
+    private:
+        bool next(void) {
+            if (!hasPending) hasPending = link.receive(&pending);
+            return hasPending;
+        }
+
+        void emit(uint16_t sampleId, uint32_t distance, Handler handler) {
+            if (distance <= window) {
+                handler(pending, sampleId);
+            } else {
+                ++stale;
+            }
+            hasPending = false;
+        }
+
+        CanLink &link;
+        uint32_t window;
+        CanFrame pending;
+        bool hasPending;
+        bool hasLast;
+        uint16_t lastId;
+        uint32_t lastTick;
+        uint32_t stale;
+};
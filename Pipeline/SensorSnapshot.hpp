@@ -0,0 +1,98 @@
+/**
+ * @file SensorSnapshot.hpp
+ * @brief The latest Blackbody temperature and irradiance readings, for
+ * attaching to stream records.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Blackbody frames carry their reading as a big endian, signed value *
+ * 1000 (after the RTD ID for temperatures). Each reading is kept with
+ * the acquisition block count it arrived at, and is only handed out
+ * while it is within the window of the record asking for it, so a board
+ * that has gone quiet shows up as not measured rather than as a frozen
+ * value.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Comms/CanLink.hpp"
+#include "Protocol/Frame.hpp"
+
+class SensorSnapshot {
+    public:
+        /** @param window Oldest reading handed out, in blocks. */
+        explicit SensorSnapshot(uint32_t window) :
+            window(window),
+            temperature(),
+            irradiance1(),
+            irradiance2() {}
+
+        /** Forget every reading, e.g. at the start of a stream. */
+        void reset(void) {
+            temperature.valid = false;
+            irradiance1.valid = false;
+            irradiance2.valid = false;
+        }
+
+        /** Keep the reading of a Blackbody frame; others are ignored. */
+        void update(const CanFrame &frame) {
+            const uint8_t *data = frame.msg.data;
+            switch (frame.msg.id) {
+                case ID_BLKBDY_TEMP:
+                    if (frame.msg.len >= 5) temperature.set(getValue(data + 1), frame.tick);
+                    break;
+                case ID_BLKBDY_IRRAD_1:
+                    if (frame.msg.len >= 4) irradiance1.set(getValue(data), frame.tick);
+                    break;
+                case ID_BLKBDY_IRRAD_2:
+                    if (frame.msg.len >= 4) irradiance2.set(getValue(data), frame.tick);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        /** Latest temperature of any RTD at tick, 0.01 C. */
+        int16_t getTemperature(uint32_t tick) const {
+            if (!temperature.fresh(tick, window)) return Frame::TEMPERATURE_NOT_MEASURED;
+            int32_t centi = temperature.value / 10;
+            return (int16_t)(centi < -INT16_MAX ? -INT16_MAX : centi > INT16_MAX ? INT16_MAX : centi);
+        }
+
+        /** Latest irradiance of sensor 1 or 2 at tick, W/m^2. */
+        uint16_t getIrradiance(uint8_t sensor, uint32_t tick) const {
+            const Reading &reading = sensor == 1 ? irradiance1 : irradiance2;
+            if (!reading.fresh(tick, window)) return Frame::IRRADIANCE_NOT_MEASURED;
+            int32_t watts = reading.value / 1000;
+            return (uint16_t)(watts < 0 ? 0 : watts >= 0xFFFF ? 0xFFFE : watts);
+        }
+
+    private:
+        struct Reading {
+            int32_t value;          /* Milli-units. */
+            uint32_t tick;
+            bool valid;
+
+            void set(int32_t value, uint32_t tick) {
+                this->value = value;
+                this->tick = tick;
+                valid = true;
+            }
+
+            /* Either side of now; the record may be read after newer frames. */
+            bool fresh(uint32_t now, uint32_t window) const {
+                int32_t age = (int32_t)(now - tick);
+                return valid && (uint32_t)(age < 0 ? -age : age) <= window;
+            }
+        };
+
+        static int32_t getValue(const uint8_t *in) {
+            return (int32_t)(((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3]);
+        }
+
+        uint32_t window;
+        Reading temperature;
+        Reading irradiance1;
+        Reading irradiance2;
+};
@@ -0,0 +1,55 @@
+/**
+ * @file SpscRing.hpp
+ * @brief Lock-free single producer, single consumer ring buffer.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Safe between one producer and one consumer running in any mix of
+ * threads and ISRs. The head is only written by the producer and the
+ * tail only by the consumer; acquire/release ordering publishes the slot
+ * contents with the index. N must be a power of two.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint16_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two.");
+
+    public:
+        SpscRing(void) : head(0), tail(0) {}
+
+        /** @return false The ring is full; item is dropped. */
+        bool push(const T &item) {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) >= N) return false;
+            slots[h & (N - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** @return false The ring is empty. */
+        bool pop(T *item) {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if (head.load(std::memory_order_acquire) == t) return false;
+            *item = slots[t & (N - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Number of queued items; exact only from the producer or consumer. */
+        uint16_t size(void) const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        bool empty(void) const { return size() == 0; }
+        static uint16_t capacity(void) { return N; }
+
+    private:
+        T slots[N];
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+};
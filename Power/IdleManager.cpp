@@ -0,0 +1,110 @@
+/**
+ * @file IdleManager.cpp
+ * @brief Parks the calling thread until a wake event, with the RX pins
+ * armed to wake the MCU from Stop 2.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#include "IdleManager.hpp"
+#include "Diagnostics/StageStats.hpp"
+
+#define FLAG_WAKE       0x1
+
+IdleManager *IdleManager::instance = nullptr;
+
+/** Both RX pins used here (PA15, PA11) share the EXTI15_10 vector. */
+static bool onSharedVector(PinName pin) {
+    return STM_PIN(pin) >= 10 && STM_PIN(pin) <= 15;
+}
+
+IdleManager::IdleManager(PinName uartRx, PinName canRx) :
+    uartRx(uartRx),
+    canRx(canRx),
+    flags(),
+    alarm(),
+    slept(),
+    onWake(),
+    source(WAKE_NONE),
+    wakeCycles(0),
+    sleptUs(0) {}
+
+void IdleManager::attach(Callback<void()> onWake) {
+    this->onWake = onWake;
+}
+
+enum WakeSource IdleManager::sleep(uint32_t alarmS, bool wakeOnCan) {
+    if (!onSharedVector(uartRx) || (wakeOnCan && !onSharedVector(canRx))) return WAKE_NONE;
+    instance = this;
+    source = WAKE_NONE;
+    flags.clear(FLAG_WAKE);
+
+    /* mbed's GPIO dispatcher owns the vector otherwise; it is put back on wake. */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    uint32_t vector = NVIC_GetVector(EXTI15_10_IRQn);
+    bool enabled = NVIC_GetEnableIRQ(EXTI15_10_IRQn) != 0;
+    NVIC_DisableIRQ(EXTI15_10_IRQn);
+    NVIC_SetVector(EXTI15_10_IRQn, (uint32_t)&IdleManager::extiIrqHandler);
+    arm(uartRx);
+    if (wakeOnCan) arm(canRx);
+    NVIC_ClearPendingIRQ(EXTI15_10_IRQn);
+    NVIC_EnableIRQ(EXTI15_10_IRQn);
+    if (alarmS > 0) alarm.attach(callback(this, &IdleManager::onAlarm), std::chrono::seconds(alarmS));
+
+    slept.reset();
+    slept.start();
+    flags.wait_any(FLAG_WAKE);
+    slept.stop();
+    sleptUs = slept.elapsed_time().count();
+
+    alarm.detach();
+    NVIC_DisableIRQ(EXTI15_10_IRQn);
+    disarm(uartRx);
+    if (wakeOnCan) disarm(canRx);
+    NVIC_SetVector(EXTI15_10_IRQn, vector);
+    NVIC_ClearPendingIRQ(EXTI15_10_IRQn);
+    if (enabled) NVIC_EnableIRQ(EXTI15_10_IRQn);
+    instance = nullptr;
+    return (enum WakeSource)source;
+}
+
+void IdleManager::arm(PinName pin) {
+    uint32_t line = STM_PIN(pin);
+    uint32_t shift = 4 * (line & 0x3);
+    SYSCFG->EXTICR[line >> 2] = (SYSCFG->EXTICR[line >> 2] & ~(0xFu << shift)) | (STM_PORT(pin) << shift);
+    EXTI->RTSR1 &= ~(1u << line);
+    EXTI->FTSR1 |= 1u << line;
+    EXTI->PR1 = 1u << line;
+    EXTI->IMR1 |= 1u << line;
+}
+
+void IdleManager::disarm(PinName pin) {
+    uint32_t line = STM_PIN(pin);
+    EXTI->IMR1 &= ~(1u << line);
+    EXTI->FTSR1 &= ~(1u << line);
+    EXTI->PR1 = 1u << line;
+}
+
+void IdleManager::wake(enum WakeSource source) {
+    /* The first event wins; later edges of the same burst are RX traffic. */
+    EXTI->IMR1 &= ~((1u << STM_PIN(uartRx)) | (1u << STM_PIN(canRx)));
+    alarm.detach();
+    if (this->source != WAKE_NONE) return;
+    wakeCycles = StageStats::now();
+    this->source = source;
+    if (onWake) onWake();
+    flags.set(FLAG_WAKE);
+}
+
+void IdleManager::extiIrqHandler(void) {
+    uint32_t pending = EXTI->PR1;
+    EXTI->PR1 = pending & (EXTI_PR1_PIF10 | EXTI_PR1_PIF11 | EXTI_PR1_PIF12
+                           | EXTI_PR1_PIF13 | EXTI_PR1_PIF14 | EXTI_PR1_PIF15);
+    if (instance == nullptr) return;
+    if (pending & (1u << STM_PIN(instance->uartRx))) {
+        instance->wake(WAKE_UART);
+    } else if (pending & (1u << STM_PIN(instance->canRx))) {
+        instance->wake(WAKE_CAN);
+    }
+}
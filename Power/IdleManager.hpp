@@ -0,0 +1,80 @@
+/**
+ * @file IdleManager.hpp
+ * @brief Parks the calling thread until a wake event, with the RX pins
+ * armed to wake the MCU from Stop 2.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * mbed enters deep sleep (Stop 2 on the L4) from the idle thread whenever
+ * nothing holds a deep sleep lock, so the caller only has to quiesce the
+ * peripherals that do (acquisition, the UART RX interrupt) before sleep().
+ * The USARTs and bxCAN cannot wake the MCU from Stop 2, so the falling
+ * edge of a start bit on the RX pin wakes it instead, through EXTI: the
+ * GPIO input stage stays live in alternate function mode, so the pin is
+ * not reconfigured. The byte that wakes the MCU is lost. The alarm runs
+ * from the low power ticker (LPTIM1), which keeps counting in Stop 2.
+ *
+ * The RX pins share the EXTI15_10 vector with every other pin numbered
+ * 10 to 15, so sleep() takes it over from mbed's GPIO dispatcher and puts
+ * it back on wake. An InterruptIn on one of those pins does not fire
+ * while the MCU sleeps, and its edges meanwhile are lost.
+ */
+
+#pragma once
+#include "mbed.h"
+
+enum WakeSource {
+    WAKE_NONE,
+    WAKE_UART,                  /* Activity on the serial RX pin. */
+    WAKE_CAN,                   /* Activity on the CAN RX pin. */
+    WAKE_ALARM                  /* The sleep() alarm expired. */
+};
+
+class IdleManager {
+    public:
+        IdleManager(PinName uartRx, PinName canRx);
+
+        /**
+         * @brief Call onWake from the wake ISR, before any thread runs,
+         * e.g. to listen on the UART again.
+         */
+        void attach(Callback<void()> onWake);
+
+        /**
+         * @brief Block until a wake event.
+         *
+         * @param alarmS Seconds until the alarm wakes the MCU; 0 for none.
+         * @param wakeOnCan Also wake on CAN bus activity.
+         * @return enum WakeSource What ended the sleep.
+         */
+        enum WakeSource sleep(uint32_t alarmS, bool wakeOnCan);
+
+        /** DWT cycle count taken in the wake ISR. */
+        uint32_t getWakeCycles(void) const { return wakeCycles; }
+
+        /** Length of the last sleep, in ms. */
+        uint32_t getSleptMs(void) const { return (uint32_t)(sleptUs / 1000); }
+
+        /** Length of the last sleep, in us, to the LPTIM resolution. */
+        uint64_t getSleptUs(void) const { return sleptUs; }
+
+    private:
+        static void extiIrqHandler(void);
+        void arm(PinName pin);
+        void disarm(PinName pin);
+        void wake(enum WakeSource source);
+        void onAlarm(void) { wake(WAKE_ALARM); }
+
+        static IdleManager *instance;
+
+        PinName uartRx;
+        PinName canRx;
+        EventFlags flags;
+        LowPowerTimeout alarm;
+        LowPowerTimer slept;
+        Callback<void()> onWake;
+        volatile uint8_t source;
+        volatile uint32_t wakeCycles;
+        uint64_t sleptUs;
+};
@@ -0,0 +1,49 @@
+/**
+ * @file Crc.hpp
+ * @brief Checksums used by the binary frames.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief CRC-8/SMBUS (poly 0x07, init 0x00), nibble table driven. Small
+ * enough to keep in flash and cheap enough for every point frame.
+ */
+inline uint8_t crc8(const uint8_t *data, uint16_t len) {
+    static const uint8_t table[16] = {
+        0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+        0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+    };
+    uint8_t crc = 0x00;
+    for (uint16_t k = 0; k < len; ++k) {
+        crc ^= data[k];
+        crc = (uint8_t)(crc << 4) ^ table[crc >> 4];
+        crc = (uint8_t)(crc << 4) ^ table[crc >> 4];
+    }
+    return crc;
+}
+
+/**
+ * @brief CRC-32/ISO-HDLC (reflected poly 0xEDB88320, init and final XOR
+ * 0xFFFFFFFF), as zlib's crc32(); nibble table driven. For records too
+ * long for CRC-8, such as the calibration record.
+ */
+inline uint32_t crc32(const uint8_t *data, uint16_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint16_t k = 0; k < len; ++k) {
+        crc ^= data[k];
+        crc = (crc >> 4) ^ table[crc & 0xF];
+        crc = (crc >> 4) ^ table[crc & 0xF];
+    }
+    return crc ^ 0xFFFFFFFF;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file DeltaFrame.hpp
+ * @brief Compressed point block: a keyframe followed by zig-zag varint
+ * deltas of the raw codes.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Neighbouring points of a sweep differ by a few codes, so after the
+ * first point of a block each field is sent as its signed difference to
+ * the one before: zig-zag mapped (0, -1, 1, -2 ... to 0, 1, 2, 3 ...) and
+ * written 7 bits a byte, least significant first, with the top bit set
+ * on all but the last byte. Point times only count up, so their
+ * differences are sent as plain varints. Every block starts from a fresh keyframe and
+ * has its own CRC, so a lost block loses only its own points.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Frame.hpp"
+
+namespace Frame {
+
+static const uint8_t DELTA_HEADER_SIZE = 7;
+static const uint8_t DELTA_KEY_SIZE = 10;
+/** Longest varint of a 16-bit difference. */
+static const uint8_t VARINT_MAX = 3;
+/** Longest varint of a 32-bit time difference. */
+static const uint8_t VARINT_TIME_MAX = 5;
+
+/** Longest block of count points. */
+constexpr uint16_t deltaMaxSize(uint8_t count) {
+    return DELTA_HEADER_SIZE + DELTA_KEY_SIZE + (count - 1) * (3 * VARINT_MAX + VARINT_TIME_MAX) + 1;
+}
+
+/** Signed to unsigned, small magnitudes first. */
+inline uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/** @return uint8_t Number of bytes written. */
+inline uint8_t putVarint(uint8_t *out, uint32_t value) {
+    uint8_t len = 0;
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+/**
+ * Builds one block in place: begin() with room for deltaMaxSize(count)
+ * bytes, add() each point in sweep order, then seal() for the length.
+ */
+class DeltaEncoder {
+    public:
+        DeltaEncoder(void) : frame(nullptr), size(0), count(0), dac(0), volt(0), curr(0), time(0) {}
+
+        /** Start a block of the points of one channel of a pass. */
+        void begin(uint8_t *out, uint8_t mode, uint16_t sampleId, uint8_t channel = 0) {
+            frame = out;
+            putHeader(frame, ID_POINT_BLOCK, typeNibble(mode, channel));
+            putField(frame + 3, sampleId, 2);
+            size = DELTA_HEADER_SIZE;
+            count = 0;
+        }
+
+        void add(uint16_t dacCode, uint16_t voltCode, uint16_t currCode, uint32_t timeUs) {
+            if (count == 0) {
+                putField(frame + size, dacCode, 2);
+                putField(frame + size + 2, voltCode, 2);
+                putField(frame + size + 4, currCode, 2);
+                putField(frame + size + 6, timeUs, 4);
+                size += DELTA_KEY_SIZE;
+            } else {
+                size += putVarint(frame + size, zigzag((int32_t)dacCode - dac));
+                size += putVarint(frame + size, zigzag((int32_t)voltCode - volt));
+                size += putVarint(frame + size, zigzag((int32_t)currCode - curr));
+                size += putVarint(frame + size, timeUs - time);
+            }
+            dac = dacCode;
+            volt = voltCode;
+            curr = currCode;
+            time = timeUs;
+            ++count;
+        }
+
+        /** @return uint16_t Length of the whole block. */
+        uint16_t seal(void) {
+            frame[5] = count;
+            frame[6] = (uint8_t)(size + 1);
+            frame[size] = crc8(frame, size);
+            return size + 1;
+        }
+
+    private:
+        uint8_t *frame;
+        uint16_t size;
+        uint8_t count;
+        uint16_t dac;
+        uint16_t volt;
+        uint16_t curr;
+        uint32_t time;
+};
+
+} // namespace Frame
@@ -0,0 +1,831 @@
+/**
+ * @file Frame.hpp
+ * @brief Binary frame encoders for the serial protocol with the PC. All
+ * fields are big endian and packed as in the README bitmaps.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Crc.hpp"
+#include "MsgIds.hpp"
+
+namespace Frame {
+
+static const uint8_t POINT_SIZE = 18;
+/** Resolution of the settle time field of a point. */
+static const uint16_t SETTLE_UNIT_US = 100;
+static const uint8_t LINK_SIZE = 7;
+static const uint8_t SUMMARY_SIZE = 21;
+static const uint8_t SENSOR_SIZE = 20;
+static const uint8_t PROFILE_SIZE = 8;
+static const uint8_t BATCH_SIZE = 11;
+static const uint8_t FINISH_SIZE = 7;
+static const uint8_t EXCEPTION_SIZE = 6;
+static const uint8_t READOUT_SIZE = 6;
+static const uint8_t READOUT_HEADER_SIZE = 10;
+/** Each point of a readout. */
+static const uint8_t PACKED_SIZE = 8;
+static const uint8_t TIMING_REQUEST_SIZE = 4;
+/** Stages in a timing record, each a min, mean and max. */
+static const uint8_t TIMING_STAGES = 5;
+static const uint8_t TIMING_SIZE = 8 + 9 * TIMING_STAGES;
+static const uint8_t WAKE_SIZE = 10;
+/** Bytes of the calibration record in each write frame. */
+static const uint8_t CAL_CHUNK = 8;
+static const uint8_t CAL_WRITE_SIZE = 6 + CAL_CHUNK;
+static const uint8_t CAL_COMMIT_SIZE = 4;
+static const uint8_t CAL_STATUS_SIZE = 10;
+static const uint8_t CAL_REFERENCE_SIZE = 14;
+static const uint8_t CAL_FIT_SIZE = 6;
+static const uint8_t CAL_READING_SIZE = 14;
+/** Reference gate voltage of a load whose gate was not measured. */
+static const uint16_t GATE_NOT_MEASURED = 0xFFFF;
+static const uint8_t STREAM_SIZE = 11;
+static const uint8_t STREAM_DATA_SIZE = 26;
+static const uint8_t STREAM_STATUS_SIZE = 17;
+static const uint8_t HYSTERESIS_SIZE = 25;
+static const uint8_t SWEEP_START_SIZE = 15;
+static const uint8_t TIME_SYNC_SIZE = 14;
+static const uint8_t TIME_SYNC_REPLY_SIZE = 30;
+/** Where the request of a time sync reply came from. */
+static const uint8_t SYNC_SERIAL = 0;
+static const uint8_t SYNC_CAN = 1;
+static const uint8_t LINK_TEST_SIZE = 7;
+static const uint8_t LINK_STATS_SIZE = 34;
+/** Sensor fields of a stream record with no recent Blackbody frame. */
+static const int16_t TEMPERATURE_NOT_MEASURED = INT16_MIN;
+static const uint16_t IRRADIANCE_NOT_MEASURED = 0xFFFF;
+/** Payload of every CAN result frame. */
+static const uint8_t CAN_SIZE = 8;
+
+/** Tracer channels the type nibble of a result frame can tell apart. */
+static const uint8_t MAX_CHANNELS = 4;
+
+/**
+ * Type nibble of a result frame: the channel in bits 3:2 and the test
+ * regime in bits 1:0, so single channel frames are unchanged.
+ */
+inline uint8_t typeNibble(uint8_t mode, uint8_t channel) {
+    return (uint8_t)((channel & 0x3) << 2) | (mode & 0x3);
+}
+
+/** Put a big endian field of the given width in bytes. */
+inline void putField(uint8_t *out, uint32_t value, uint8_t width) {
+    for (uint8_t k = 0; k < width; ++k) {
+        out[k] = (uint8_t)(value >> (8 * (width - 1 - k)));
+    }
+}
+
+/** Put a device or host time, us, as a big endian field of 8 bytes. */
+inline void putTime(uint8_t *out, uint64_t us) {
+    putField(out, (uint32_t)(us >> 32), 4);
+    putField(out + 4, (uint32_t)us, 4);
+}
+
+/** Get a big endian field of up to 8 bytes. */
+inline uint64_t getTime(const uint8_t *in, uint8_t width) {
+    uint64_t us = 0;
+    for (uint8_t k = 0; k < width; ++k) us = (us << 8) | in[k];
+    return us;
+}
+
+/** Prelude, 12-bit ID and the 4-bit nibble that follows it. */
+inline void putHeader(uint8_t *out, uint16_t msgId, uint8_t nibble) {
+    out[0] = PRELUDE;
+    out[1] = (uint8_t)(msgId >> 4);
+    out[2] = (uint8_t)((msgId & 0xF) << 4) | (nibble & 0xF);
+}
+
+/**
+ * @brief Encode a sweep point. Voltage and current are the mean raw ADC
+ * codes in Q12.4; the host applies the calibration of the given mode.
+ * settle is the settle time used, in SETTLE_UNIT_US, saturating at 0xFF.
+ * The noise fields are the RMS noise of each sensor in Q12.4 codes.
+ * timeUs is the low 32 bits of the device time sampling ended at.
+ * channel is the tracer channel, shared with mode in the type nibble.
+ *
+ * @return uint8_t Number of bytes written, POINT_SIZE.
+ */
+inline uint8_t encodePoint(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t sampleId,
+    uint16_t dacCode,
+    uint16_t volt,
+    uint16_t curr,
+    uint8_t settle,
+    uint8_t voltNoise,
+    uint8_t currNoise,
+    uint32_t timeUs,
+    uint8_t channel = 0
+) {
+    putHeader(out, ID_POINT, typeNibble(mode, channel));
+    out[3] = (uint8_t)(sampleId >> 4);
+    out[4] = (uint8_t)((sampleId & 0xF) << 4) | ((dacCode >> 8) & 0xF);
+    out[5] = (uint8_t)dacCode;
+    out[6] = (uint8_t)(volt >> 8);
+    out[7] = (uint8_t)volt;
+    out[8] = (uint8_t)(curr >> 8);
+    out[9] = (uint8_t)curr;
+    out[10] = settle;
+    out[11] = voltNoise;
+    out[12] = currNoise;
+    putField(out + 13, timeUs, 4);
+    out[17] = crc8(out, POINT_SIZE - 1);
+    return POINT_SIZE;
+}
+
+/**
+ * @brief Encode the figures of merit of one sweep. Currents are mA,
+ * voltages mV and power mW, clamped to their field widths; the fill
+ * factor is Q0.16. The channel shares the type nibble as in encodePoint().
+ *
+ * @return uint8_t Number of bytes written, SUMMARY_SIZE.
+ */
+inline uint8_t encodeSummary(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t sweepId,
+    int32_t isc,
+    int32_t voc,
+    int32_t imp,
+    int32_t vmp,
+    int32_t pmax,
+    uint16_t fillFactor,
+    uint8_t channel = 0
+) {
+    #define CLAMP(x, max) ((x) < 0 ? 0 : (uint32_t)(x) > (max) ? (max) : (uint32_t)(x))
+    putHeader(out, ID_SUMMARY, typeNibble(mode, channel));
+    putField(out + 3, sweepId, 2);
+    putField(out + 5, CLAMP(isc, 0xFFFF), 2);
+    putField(out + 7, CLAMP(voc, 0xFFFFFF), 3);
+    putField(out + 10, CLAMP(imp, 0xFFFF), 2);
+    putField(out + 12, CLAMP(vmp, 0xFFFFFF), 3);
+    putField(out + 15, CLAMP(pmax, 0xFFFFFF), 3);
+    putField(out + 18, fillFactor, 2);
+    out[20] = crc8(out, SUMMARY_SIZE - 1);
+    return SUMMARY_SIZE;
+    #undef CLAMP
+}
+
+/** Encode a link offer/accept carrying a 24-bit baud rate. */
+inline uint8_t encodeLink(uint8_t *out, uint16_t msgId, uint32_t baud) {
+    putHeader(out, msgId, 0);
+    out[3] = (uint8_t)(baud >> 16);
+    out[4] = (uint8_t)(baud >> 8);
+    out[5] = (uint8_t)baud;
+    out[6] = crc8(out, LINK_SIZE - 1);
+    return LINK_SIZE;
+}
+
+/**
+ * @brief Decode a link frame with the expected ID.
+ *
+ * @return true The frame is intact; baud holds the carried rate.
+ */
+inline bool decodeLink(const uint8_t *in, uint16_t msgId, uint32_t *baud) {
+    if (in[0] != PRELUDE) return false;
+    if ((uint16_t)((in[1] << 4) | (in[2] >> 4)) != msgId) return false;
+    if (crc8(in, LINK_SIZE - 1) != in[6]) return false;
+    *baud = ((uint32_t)in[3] << 16) | ((uint32_t)in[4] << 8) | in[5];
+    return true;
+}
+
+/** Length of a frame from the PC with the given ID; 0 if unknown. */
+inline uint8_t inputSize(uint16_t msgId) {
+    switch (msgId) {
+        case ID_LINK_ACCEPT:
+            return LINK_SIZE;
+        case ID_PROFILE:
+            return PROFILE_SIZE;
+        case ID_PROFILE_BATCH:
+            return BATCH_SIZE;
+        case ID_READOUT:
+            return READOUT_SIZE;
+        case ID_TIMING_REQUEST:
+            return TIMING_REQUEST_SIZE;
+        case ID_CAL_WRITE:
+            return CAL_WRITE_SIZE;
+        case ID_CAL_COMMIT:
+            return CAL_COMMIT_SIZE;
+        case ID_CAL_REFERENCE:
+            return CAL_REFERENCE_SIZE;
+        case ID_CAL_FIT:
+            return CAL_FIT_SIZE;
+        case ID_STREAM:
+            return STREAM_SIZE;
+        case ID_TIME_SYNC:
+            return TIME_SYNC_SIZE;
+        case ID_LINK_TEST:
+            return LINK_TEST_SIZE;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Split a profile frame into its fields: the regime and the
+ * start, end and resolution voltages in mV. The frame has no CRC; the
+ * fields must be validated by the caller.
+ */
+inline void decodeProfile(
+    const uint8_t *in,
+    uint8_t *regime,
+    uint16_t *startMv,
+    uint16_t *endMv,
+    uint16_t *resolutionMv
+) {
+    *regime = in[3] >> 4;
+    *startMv = (uint16_t)(((in[3] & 0xF) << 8) | in[4]);
+    *endMv = (uint16_t)((in[5] << 4) | (in[6] >> 4));
+    *resolutionMv = (uint16_t)(((in[6] & 0xF) << 8) | in[7]);
+}
+
+/**
+ * @brief Split a batch profile frame into its fields: the regime, the
+ * start, end and resolution voltages in mV, the log2 of the blocks per
+ * point, the settle time in 100 us and the number of pass pairs.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeBatch(
+    const uint8_t *in,
+    uint8_t *regime,
+    uint16_t *startMv,
+    uint16_t *endMv,
+    uint16_t *resolutionMv,
+    uint8_t *blockShift,
+    uint8_t *settle,
+    uint8_t *repeats
+) {
+    if (crc8(in, BATCH_SIZE - 1) != in[BATCH_SIZE - 1]) return false;
+    *regime = in[2] & 0xF;
+    *startMv = (uint16_t)((in[3] << 4) | (in[4] >> 4));
+    *endMv = (uint16_t)(((in[4] & 0xF) << 8) | in[5]);
+    *resolutionMv = (uint16_t)((in[6] << 4) | (in[7] >> 4));
+    *blockShift = in[7] & 0xF;
+    *settle = in[8];
+    *repeats = in[9];
+    return true;
+}
+
+/**
+ * @brief Encode the completion of a profile: its regime, ID and the
+ * number of passes run.
+ *
+ * @return uint8_t Number of bytes written, FINISH_SIZE.
+ */
+inline uint8_t encodeFinish(uint8_t *out, uint8_t mode, uint16_t profileId, uint8_t passes) {
+    putHeader(out, ID_FINISH, mode);
+    putField(out + 3, profileId, 2);
+    out[5] = passes;
+    out[6] = crc8(out, FINISH_SIZE - 1);
+    return FINISH_SIZE;
+}
+
+/**
+ * @brief Read the sweep ID out of a readout request.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeReadout(const uint8_t *in, uint16_t *sweepId) {
+    if (crc8(in, READOUT_SIZE - 1) != in[READOUT_SIZE - 1]) return false;
+    *sweepId = (uint16_t)((in[3] << 8) | in[4]);
+    return true;
+}
+
+/** Length of a readout frame carrying count points. */
+inline uint16_t readoutSize(uint8_t count) {
+    return READOUT_HEADER_SIZE + (uint16_t)count * PACKED_SIZE + 1;
+}
+
+/**
+ * @brief Encode the header of a readout frame: the regime, sweep ID and
+ * point count of the pass, then the index of the first point in this
+ * frame and how many follow. The points are added with encodePacked()
+ * and the frame closed with sealReadout().
+ *
+ * @return uint8_t Number of bytes written, READOUT_HEADER_SIZE.
+ */
+inline uint8_t encodeReadoutHeader(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t sweepId,
+    uint16_t total,
+    uint16_t offset,
+    uint8_t count
+) {
+    putHeader(out, ID_READOUT_DATA, mode);
+    putField(out + 3, sweepId, 2);
+    putField(out + 5, total, 2);
+    putField(out + 7, offset, 2);
+    out[9] = count;
+    return READOUT_HEADER_SIZE;
+}
+
+/**
+ * @brief Encode one point of a readout frame.
+ *
+ * @return uint8_t Number of bytes written, PACKED_SIZE.
+ */
+inline uint8_t encodePacked(
+    uint8_t *out,
+    uint16_t dacCode,
+    uint16_t volt,
+    uint16_t curr,
+    uint8_t settle,
+    uint8_t noise
+) {
+    putField(out, dacCode, 2);
+    putField(out + 2, volt, 2);
+    putField(out + 4, curr, 2);
+    out[6] = settle;
+    out[7] = noise;
+    return PACKED_SIZE;
+}
+
+/**
+ * @brief Append the CRC of a readout frame of count points.
+ *
+ * @return uint16_t Length of the whole frame.
+ */
+inline uint16_t sealReadout(uint8_t *out, uint8_t count) {
+    uint16_t size = readoutSize(count);
+    out[size - 1] = crc8(out, size - 1);
+    return size;
+}
+
+/**
+ * @brief Encode the stage timing of a sweep pass: its sweep ID and point
+ * count, then the min, mean and max of each stage in CPU cycles, clamped
+ * to 24 bits.
+ *
+ * @param cycles TIMING_STAGES triples of min, mean and max.
+ * @return uint8_t Number of bytes written, TIMING_SIZE.
+ */
+inline uint8_t encodeTiming(uint8_t *out, uint16_t sweepId, uint16_t points, const uint32_t *cycles) {
+    putHeader(out, ID_TIMING, 0);
+    putField(out + 3, sweepId, 2);
+    putField(out + 5, points, 2);
+    for (uint8_t k = 0; k < 3 * TIMING_STAGES; ++k) {
+        putField(out + 7 + 3 * k, cycles[k] > 0xFFFFFF ? 0xFFFFFF : cycles[k], 3);
+    }
+    out[TIMING_SIZE - 1] = crc8(out, TIMING_SIZE - 1);
+    return TIMING_SIZE;
+}
+
+/**
+ * @brief Read a chunk of a calibration record: its offset in the record
+ * and CAL_CHUNK bytes, left in place.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeCalWrite(const uint8_t *in, uint16_t *offset, const uint8_t **data) {
+    if (crc8(in, CAL_WRITE_SIZE - 1) != in[CAL_WRITE_SIZE - 1]) return false;
+    *offset = (uint16_t)((in[3] << 8) | in[4]);
+    *data = in + 5;
+    return true;
+}
+
+/**
+ * @brief Read a reference load: the regime and DAC code to measure it at,
+ * and the true voltage (mV), current (mA) and gate voltage (mV, or
+ * GATE_NOT_MEASURED) at that code.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeCalReference(
+    const uint8_t *in,
+    uint8_t *regime,
+    uint16_t *dacCode,
+    uint32_t *voltMv,
+    uint32_t *currMa,
+    uint16_t *gateMv
+) {
+    if (crc8(in, CAL_REFERENCE_SIZE - 1) != in[CAL_REFERENCE_SIZE - 1]) return false;
+    *regime = in[2] & 0xF;
+    *dacCode = (uint16_t)((in[3] << 8) | in[4]);
+    *voltMv = ((uint32_t)in[5] << 16) | (in[6] << 8) | in[7];
+    *currMa = ((uint32_t)in[8] << 16) | (in[9] << 8) | in[10];
+    *gateMv = (uint16_t)((in[11] << 8) | in[12]);
+    return true;
+}
+
+/**
+ * @brief Read a fit request: the revision to store the fitted record
+ * under, 0 for the next one.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeCalFit(const uint8_t *in, uint16_t *revision) {
+    if (crc8(in, CAL_FIT_SIZE - 1) != in[CAL_FIT_SIZE - 1]) return false;
+    *revision = (uint16_t)((in[3] << 8) | in[4]);
+    return true;
+}
+
+/**
+ * @brief Encode the reading of a reference load: the DAC code, the mean
+ * raw codes and noise as in the point frame, and the readings collected
+ * for the regime so far.
+ *
+ * @return uint8_t Number of bytes written, CAL_READING_SIZE.
+ */
+inline uint8_t encodeCalReading(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t dacCode,
+    uint16_t volt,
+    uint16_t curr,
+    uint8_t voltNoise,
+    uint8_t currNoise,
+    uint16_t readings
+) {
+    putHeader(out, ID_CAL_READING, mode);
+    putField(out + 3, dacCode, 2);
+    putField(out + 5, volt, 2);
+    putField(out + 7, curr, 2);
+    out[9] = voltNoise;
+    out[10] = currNoise;
+    putField(out + 11, readings, 2);
+    out[CAL_READING_SIZE - 1] = crc8(out, CAL_READING_SIZE - 1);
+    return CAL_READING_SIZE;
+}
+
+/**
+ * @brief Encode the calibration in use: whether it came from the store
+ * (1) or is built in (0), the record revision and its CRC-32.
+ *
+ * @return uint8_t Number of bytes written, CAL_STATUS_SIZE.
+ */
+inline uint8_t encodeCalStatus(uint8_t *out, bool stored, uint16_t revision, uint32_t recordCrc) {
+    putHeader(out, ID_CAL_STATUS, stored ? 1 : 0);
+    putField(out + 3, revision, 2);
+    putField(out + 5, recordCrc, 4);
+    out[CAL_STATUS_SIZE - 1] = crc8(out, CAL_STATUS_SIZE - 1);
+    return CAL_STATUS_SIZE;
+}
+
+/**
+ * @brief Encode a wake report: what woke the MCU, how long it slept, in
+ * ms, and the time from the wake interrupt to the first ADC block of the
+ * sweep that followed, in us. Both saturate at 24 bits.
+ *
+ * @return uint8_t Number of bytes written, WAKE_SIZE.
+ */
+inline uint8_t encodeWake(uint8_t *out, uint8_t source, uint32_t sleptMs, uint32_t latencyUs) {
+    putHeader(out, ID_WAKE, source);
+    putField(out + 3, sleptMs > 0xFFFFFF ? 0xFFFFFF : sleptMs, 3);
+    putField(out + 6, latencyUs > 0xFFFFFF ? 0xFFFFFF : latencyUs, 3);
+    out[WAKE_SIZE - 1] = crc8(out, WAKE_SIZE - 1);
+    return WAKE_SIZE;
+}
+
+/**
+ * @brief Split a stream request: the regime, the DAC output voltage to
+ * hold or start from and the dither step, in mV, the records per second
+ * and the length in s (0 until stopped). A rate of 0 stops the stream.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeStream(
+    const uint8_t *in,
+    uint8_t *regime,
+    uint16_t *dacMv,
+    uint8_t *ditherMv,
+    uint16_t *rateHz,
+    uint16_t *durationS
+) {
+    if (crc8(in, STREAM_SIZE - 1) != in[STREAM_SIZE - 1]) return false;
+    *regime = in[2] & 0xF;
+    *dacMv = (uint16_t)((in[3] << 8) | in[4]);
+    *ditherMv = in[5];
+    *rateHz = (uint16_t)((in[6] << 8) | in[7]);
+    *durationS = (uint16_t)((in[8] << 8) | in[9]);
+    return true;
+}
+
+/**
+ * @brief Encode a stream record: its index, the DAC code it was taken at,
+ * the mean voltage (mV), current (mA) and power (mW), clamped as in
+ * encodeSummary(), the latest Blackbody temperature (0.01 C) and
+ * irradiances (W/m^2), and the low 32 bits of the device time the
+ * record ended at.
+ *
+ * @return uint8_t Number of bytes written, STREAM_DATA_SIZE.
+ */
+inline uint8_t encodeStreamData(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t index,
+    uint16_t dacCode,
+    int32_t voltage,
+    int32_t current,
+    int32_t power,
+    int16_t temperature,
+    uint16_t irradiance1,
+    uint16_t irradiance2,
+    uint32_t timeUs
+) {
+    #define CLAMP(x, max) ((x) < 0 ? 0 : (uint32_t)(x) > (max) ? (max) : (uint32_t)(x))
+    putHeader(out, ID_STREAM_DATA, mode);
+    putField(out + 3, index, 2);
+    putField(out + 5, dacCode & 0xFFF, 2);
+    putField(out + 7, CLAMP(voltage, 0xFFFFFF), 3);
+    putField(out + 10, CLAMP(current, 0xFFFF), 2);
+    putField(out + 12, CLAMP(power, 0xFFFFFF), 3);
+    putField(out + 15, (uint16_t)temperature, 2);
+    putField(out + 17, irradiance1, 2);
+    putField(out + 19, irradiance2, 2);
+    putField(out + 21, timeUs, 4);
+    out[STREAM_DATA_SIZE - 1] = crc8(out, STREAM_DATA_SIZE - 1);
+    return STREAM_DATA_SIZE;
+    #undef CLAMP
+}
+
+/**
+ * @brief Encode the counters of a stream: records taken, records dropped
+ * on the device before the link and records the link had no room for,
+ * and why it ended (0 while it runs).
+ *
+ * @return uint8_t Number of bytes written, STREAM_STATUS_SIZE.
+ */
+inline uint8_t encodeStreamStatus(
+    uint8_t *out,
+    uint8_t mode,
+    uint32_t records,
+    uint32_t dropped,
+    uint32_t unsent,
+    uint8_t reason
+) {
+    putHeader(out, ID_STREAM_STATUS, mode);
+    putField(out + 3, records, 4);
+    putField(out + 7, dropped, 4);
+    putField(out + 11, unsent, 4);
+    out[15] = reason;
+    out[STREAM_STATUS_SIZE - 1] = crc8(out, STREAM_STATUS_SIZE - 1);
+    return STREAM_STATUS_SIZE;
+}
+
+/**
+ * @brief Encode the forward/reverse difference of a pass pair of one
+ * channel: the sweep IDs of both passes, the points matched by DAC code,
+ * the largest current difference (mA) and its code, the mean current
+ * difference (mA), the largest power difference (mW) and that over the
+ * forward peak power in Q0.16. settle is the settle time the pair was
+ * swept with and nextSettle the one tuned for the next pair, both in
+ * SETTLE_UNIT_US and 0 when not tuning.
+ *
+ * @return uint8_t Number of bytes written, HYSTERESIS_SIZE.
+ */
+inline uint8_t encodeHysteresis(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t forwardId,
+    uint16_t reverseId,
+    uint16_t matched,
+    int32_t maxCurrDiff,
+    uint16_t maxDacCode,
+    int32_t meanCurrDiff,
+    int32_t maxPowerDiff,
+    uint16_t ratio,
+    uint16_t settle,
+    uint16_t nextSettle,
+    uint8_t channel = 0
+) {
+    #define CLAMP(x, max) ((x) < 0 ? 0 : (uint32_t)(x) > (max) ? (max) : (uint32_t)(x))
+    putHeader(out, ID_HYSTERESIS, typeNibble(mode, channel));
+    putField(out + 3, forwardId, 2);
+    putField(out + 5, reverseId, 2);
+    putField(out + 7, matched, 2);
+    putField(out + 9, CLAMP(maxCurrDiff, 0xFFFF), 2);
+    putField(out + 11, maxDacCode & 0xFFF, 2);
+    putField(out + 13, CLAMP(meanCurrDiff, 0xFFFF), 2);
+    putField(out + 15, CLAMP(maxPowerDiff, 0xFFFFFF), 3);
+    putField(out + 18, ratio, 2);
+    putField(out + 20, settle, 2);
+    putField(out + 22, nextSettle, 2);
+    out[HYSTERESIS_SIZE - 1] = crc8(out, HYSTERESIS_SIZE - 1);
+    return HYSTERESIS_SIZE;
+    #undef CLAMP
+}
+
+/**
+ * @brief Encode the start of a sweep pass: its sweep ID, whether it runs
+ * from the last code to the first, and the device time it started at.
+ *
+ * @return uint8_t Number of bytes written, SWEEP_START_SIZE.
+ */
+inline uint8_t encodeSweepStart(uint8_t *out, uint8_t mode, uint16_t sweepId, bool reverse, uint64_t startUs) {
+    putHeader(out, ID_SWEEP_START, mode);
+    putField(out + 3, sweepId, 2);
+    out[5] = reverse ? 1 : 0;
+    putTime(out + 6, startUs);
+    out[SWEEP_START_SIZE - 1] = crc8(out, SWEEP_START_SIZE - 1);
+    return SWEEP_START_SIZE;
+}
+
+/**
+ * @brief Split a time sync request into its sequence number and the host
+ * time it was sent at, which is only echoed.
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeTimeSync(const uint8_t *in, uint16_t *sequence, uint64_t *hostUs) {
+    if (crc8(in, TIME_SYNC_SIZE - 1) != in[TIME_SYNC_SIZE - 1]) return false;
+    *sequence = (uint16_t)((in[3] << 8) | in[4]);
+    *hostUs = getTime(in + 5, 8);
+    return true;
+}
+
+/**
+ * @brief Encode the reply to a time sync request from source: the
+ * request's sequence number and host time, the device time it was
+ * received at and the device time the reply was queued at.
+ *
+ * @return uint8_t Number of bytes written, TIME_SYNC_REPLY_SIZE.
+ */
+inline uint8_t encodeTimeSyncReply(
+    uint8_t *out,
+    uint8_t source,
+    uint16_t sequence,
+    uint64_t hostUs,
+    uint64_t receivedUs,
+    uint64_t sentUs
+) {
+    putHeader(out, ID_TIME_SYNC_REPLY, source);
+    putField(out + 3, sequence, 2);
+    putTime(out + 5, hostUs);
+    putTime(out + 13, receivedUs);
+    putTime(out + 21, sentUs);
+    out[TIME_SYNC_REPLY_SIZE - 1] = crc8(out, TIME_SYNC_REPLY_SIZE - 1);
+    return TIME_SYNC_REPLY_SIZE;
+}
+
+/**
+ * @brief Encode an exception: the ID of the message at fault, a 12-bit
+ * error code and a 16-bit context.
+ *
+ * @return uint8_t Number of bytes written, EXCEPTION_SIZE.
+ */
+inline uint8_t encodeException(uint8_t *out, uint16_t msgId, uint16_t code, uint16_t context) {
+    putHeader(out, msgId, code >> 8);
+    out[3] = (uint8_t)code;
+    putField(out + 4, context, 2);
+    return EXCEPTION_SIZE;
+}
+
+/**
+ * @brief Encode a Blackbody CAN frame forwarded to the PC, tagged with
+ * the sample ID of the nearest sweep point and the low 32 bits of the
+ * device time it was received at. The payload is passed on as received
+ * and zero padded to 8 bytes; len is its original length.
+ *
+ * @return uint8_t Number of bytes written, SENSOR_SIZE.
+ */
+inline uint8_t encodeSensor(
+    uint8_t *out,
+    uint16_t canId,
+    uint16_t sampleId,
+    const uint8_t *data,
+    uint8_t len,
+    uint32_t timeUs
+) {
+    if (len > 8) len = 8;
+    putHeader(out, ID_SENSOR, len);
+    putField(out + 3, canId & 0x7FF, 2);
+    putField(out + 5, sampleId & 0xFFF, 2);
+    for (uint8_t k = 0; k < 8; ++k) out[7 + k] = k < len ? data[k] : 0;
+    putField(out + 15, timeUs, 4);
+    out[SENSOR_SIZE - 1] = crc8(out, SENSOR_SIZE - 1);
+    return SENSOR_SIZE;
+}
+
+/**
+ * @brief Encode the CAN payload of a sweep point: type nibble, sample
+ * ID, mean voltage and current codes in Q12.4 and the DAC code, in one
+ * frame.
+ *
+ * @return uint8_t Number of bytes written, CAN_SIZE.
+ */
+inline uint8_t encodeCanPoint(
+    uint8_t *out,
+    uint8_t mode,
+    uint16_t sampleId,
+    uint16_t dacCode,
+    uint16_t volt,
+    uint16_t curr,
+    uint8_t channel = 0
+) {
+    out[0] = (uint8_t)(typeNibble(mode, channel) << 4) | ((sampleId >> 8) & 0xF);
+    out[1] = (uint8_t)sampleId;
+    putField(out + 2, volt, 2);
+    putField(out + 4, curr, 2);
+    putField(out + 6, dacCode & 0xFFF, 2);
+    return CAN_SIZE;
+}
+
+/**
+ * @brief Encode the two CAN payloads of a sweep summary: Isc, Voc and
+ * Pmax in ID_SUMMARY, and Imp, Vmp, the fill factor, the channel and the
+ * low 6 bits of the sweep ID in ID_SUMMARY_MPP. Units and clamping as
+ * encodeSummary().
+ */
+inline void encodeCanSummary(
+    uint8_t *summary,
+    uint8_t *mpp,
+    uint16_t sweepId,
+    int32_t isc,
+    int32_t voc,
+    int32_t imp,
+    int32_t vmp,
+    int32_t pmax,
+    uint16_t fillFactor,
+    uint8_t channel = 0
+) {
+    #define CLAMP(x, max) ((x) < 0 ? 0 : (uint32_t)(x) > (max) ? (max) : (uint32_t)(x))
+    putField(summary, CLAMP(isc, 0xFFFF), 2);
+    putField(summary + 2, CLAMP(voc, 0xFFFFFF), 3);
+    putField(summary + 5, CLAMP(pmax, 0xFFFFFF), 3);
+    putField(mpp, CLAMP(imp, 0xFFFF), 2);
+    putField(mpp + 2, CLAMP(vmp, 0xFFFFFF), 3);
+    putField(mpp + 5, fillFactor, 2);
+    mpp[7] = (uint8_t)((channel & 0x3) << 6) | (sweepId & 0x3F);
+    #undef CLAMP
+}
+
+/**
+ * @brief Split a CAN time sync frame: the sequence number and the low 48
+ * bits of the sender's time, us.
+ *
+ * @return false Not a full payload.
+ */
+inline bool decodeCanTimeSync(const uint8_t *data, uint8_t len, uint16_t *sequence, uint64_t *senderUs) {
+    if (len != CAN_SIZE) return false;
+    *sequence = (uint16_t)((data[0] << 8) | data[1]);
+    *senderUs = getTime(data + 2, 6);
+    return true;
+}
+
+/**
+ * @brief Encode the CAN reply to a time sync frame: its sequence number
+ * and the low 48 bits of the device time it was received at, us.
+ */
+inline void encodeCanTimeSyncReply(uint8_t *data, uint16_t sequence, uint64_t receivedUs) {
+    putField(data, sequence, 2);
+    putField(data + 2, (uint32_t)(receivedUs >> 32) & 0xFFFF, 2);
+    putField(data + 4, (uint32_t)receivedUs, 4);
+}
+
+/**
+ * @brief Split a link test request into the synthetic records to send
+ * down each output path and the bit mask of the paths (0 for all).
+ *
+ * @return false The CRC does not match.
+ */
+inline bool decodeLinkTest(const uint8_t *in, uint16_t *records, uint8_t *paths) {
+    if (crc8(in, LINK_TEST_SIZE - 1) != in[LINK_TEST_SIZE - 1]) return false;
+    *records = (uint16_t)((in[3] << 8) | in[4]);
+    *paths = in[5];
+    return true;
+}
+
+/**
+ * @brief Encode the figures of one output path of a link test: the
+ * records and bytes sent, the time from the first record until the link
+ * drained (us) and the rates over it, records dropped and records that
+ * waited for room, the encoder CPU cycles per record and the link rate
+ * (baud or CAN bits/s).
+ *
+ * @return uint8_t Number of bytes written, LINK_STATS_SIZE.
+ */
+inline uint8_t encodeLinkStats(
+    uint8_t *out,
+    uint8_t path,
+    uint16_t records,
+    uint32_t bytes,
+    uint32_t elapsedUs,
+    uint32_t bytesPerS,
+    uint32_t recordsPerS,
+    uint16_t dropped,
+    uint16_t waits,
+    uint32_t cyclesPerRecord,
+    uint32_t linkRate
+) {
+    putHeader(out, ID_LINK_STATS, path);
+    putField(out + 3, records, 2);
+    putField(out + 5, bytes, 4);
+    putField(out + 9, elapsedUs, 4);
+    putField(out + 13, bytesPerS, 4);
+    putField(out + 17, recordsPerS, 4);
+    putField(out + 21, dropped, 2);
+    putField(out + 23, waits, 2);
+    putField(out + 25, cyclesPerRecord, 4);
+    putField(out + 29, linkRate, 4);
+    out[LINK_STATS_SIZE - 1] = crc8(out, LINK_STATS_SIZE - 1);
+    return LINK_STATS_SIZE;
+}
+
+} // namespace Frame
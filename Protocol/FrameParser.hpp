@@ -0,0 +1,68 @@
+/**
+ * @file FrameParser.hpp
+ * @brief Incremental parser for frames from the PC, fed one byte at a
+ * time from the UART RX interrupt.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * A frame starts at a 0xFF prelude; the 12-bit ID that follows sets its
+ * length (Frame::inputSize()). Unknown IDs resynchronise on the next
+ * prelude in the bytes already seen, so a corrupted or truncated frame
+ * costs at most itself. Field validation is up to the consumer.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Frame.hpp"
+
+class FrameParser {
+    public:
+        /** Longest frame the PC sends. */
+        static const uint8_t MAX_SIZE = 14;
+
+        FrameParser(void) : count(0), expected(0) {}
+
+        /**
+         * @brief Consume one byte.
+         *
+         * @return true A whole frame is in data() until the next feed().
+         */
+        bool feed(uint8_t byte) {
+            if (count == 0 && byte != PRELUDE) return false;
+            frame[count++] = byte;
+            if (count < 3) return false;
+
+            if (count == 3) {
+                expected = Frame::inputSize(id());
+                if (expected == 0 || expected > MAX_SIZE) {
+                    resync();
+                    return false;
+                }
+            }
+            if (count < expected) return false;
+            count = 0;
+            return true;
+        }
+
+        /** Drop any partial frame. */
+        void reset(void) { count = 0; }
+
+        /** ID of the frame in data(). */
+        uint16_t id(void) const { return (uint16_t)((frame[1] << 4) | (frame[2] >> 4)); }
+        const uint8_t *data(void) const { return frame; }
+        uint8_t size(void) const { return expected; }
+
+    private:
+        /** Restart from the next prelude after the first byte, if any. */
+        void resync(void) {
+            uint8_t from = 1;
+            while (from < count && frame[from] != PRELUDE) ++from;
+            for (uint8_t k = from; k < count; ++k) frame[k - from] = frame[k];
+            count -= from;
+        }
+
+        uint8_t frame[MAX_SIZE];
+        uint8_t count;
+        uint8_t expected;
+};
@@ -0,0 +1,60 @@
+/**
+ * @file MsgIds.hpp
+ * @brief Message IDs and framing constants for the serial protocol with
+ * the PC and the CAN bus. See the README "Serial communication protocol
+ * with PC" and "CAN communication protocol". Point and summary results
+ * use the same IDs on both.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+
+#define PRELUDE                 0xFF
+
+/** PC to Curve Tracer. */
+#define ID_LINK_ACCEPT          0x641
+#define ID_PROFILE              0x642
+#define ID_PROFILE_BATCH        0x643
+#define ID_READOUT              0x644
+#define ID_TIMING_REQUEST       0x645
+#define ID_CAL_WRITE            0x646
+#define ID_CAL_COMMIT           0x647
+#define ID_CAL_REFERENCE        0x648
+#define ID_CAL_FIT              0x649
+#define ID_STREAM               0x64A
+#define ID_TIME_SYNC            0x64B
+#define ID_LINK_TEST            0x64C
+
+/** Curve Tracer to PC. */
+#define ID_LINK_OFFER           0x650
+#define ID_POINT                0x651
+#define ID_SUMMARY              0x652
+#define ID_SENSOR               0x654
+#define ID_FINISH               0x655
+#define ID_READOUT_DATA         0x656
+#define ID_POINT_BLOCK          0x657
+#define ID_TIMING               0x658
+#define ID_WAKE                 0x659
+#define ID_CAL_STATUS           0x65A
+#define ID_CAL_READING          0x65B
+#define ID_STREAM_DATA          0x65C
+#define ID_STREAM_STATUS        0x65D
+#define ID_HYSTERESIS           0x65E
+#define ID_SWEEP_START          0x65F
+#define ID_TIME_SYNC_REPLY      0x660
+#define ID_FAULT                0x661
+#define ID_LINK_STATS           0x662
+
+/** Curve Tracer to CAN bus; ID_POINT, ID_SUMMARY and the time sync IDs are shared. */
+#define ID_SUMMARY_MPP          0x653
+
+/** Blackbody boards to CAN bus. */
+#define ID_BLKBDY_TEMP          0x620
+#define ID_BLKBDY_IRRAD_1       0x630
+#define ID_BLKBDY_IRRAD_2       0x631
+#define ID_BLKBDY_FAULT         0x633
+
+/** Curve Tracer to Blackbody boards. */
+#define ID_BLKBDY_EN_DIS        0x632
@@ -0,0 +1,139 @@
+/**
+ * @file AdaptiveStepper.hpp
+ * @brief Chooses the next DAC code of a sweep from the points measured so
+ * far: coarse steps across the flat Isc and Voc regions, fine steps where
+ * the power curve bends, around the maximum power point.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The step is controlled like an adaptive ODE step. Each new point is
+ * compared against the linear extrapolation of the two before it; the
+ * miss, relative to the largest power seen so far, is the local error.
+ * The step halves while the error is above tolerance and doubles while
+ * it is well below, so the points bunch up around the knee, where the
+ * power curve turns over at the maximum power point. Voltage and current
+ * are raw mean codes, so the power is only proportional to watts; the
+ * ratios are all that matter.
+ */
+
+#pragma once
+#include <stdint.h>
+
+class AdaptiveStepper {
+    public:
+        /**
+         * @param minStep Finest step, in DAC codes.
+         * @param maxStep Coarsest step, in DAC codes.
+         * @param budget Largest number of points in a sweep.
+         * @param tolerance Local error bound, as a fraction of the running
+         * peak power in 1/256.
+         */
+        AdaptiveStepper(uint16_t minStep, uint16_t maxStep, uint16_t budget, uint16_t tolerance) :
+            minStep(minStep),
+            maxStep(maxStep),
+            budget(budget),
+            tolerance(tolerance) {
+            begin(0, 0);
+        }
+
+        /** Start a new sweep from start to end, in either direction. */
+        void begin(uint16_t start, uint16_t end) {
+            this->start = start;
+            this->end = end;
+            code = start;
+            step = maxStep;
+            count = 0;
+            known = 0;
+            peak = 0;
+            done = false;
+        }
+
+        /**
+         * @brief Get the DAC code to measure next.
+         *
+         * @return false The sweep has reached its end or its budget.
+         */
+        bool next(uint16_t *out) {
+            if (done || count >= budget) return false;
+            *out = code;
+            return true;
+        }
+
+        /** Record the measurement taken at the code returned by next(). */
+        void update(uint16_t volt, uint16_t curr) {
+            uint32_t power = (uint32_t)volt * curr;
+            ++count;
+
+            /* Local error against the extrapolation of the last two points. */
+            if (known == 2) {
+                int64_t dx1 = (int64_t)x[1] - x[0];
+                int64_t dx2 = (int64_t)code - x[1];
+                int64_t predicted = (int64_t)p[1] + ((int64_t)p[1] - p[0]) * dx2 / dx1;
+                int64_t miss = (int64_t)power - predicted;
+                if (miss < 0) miss = -miss;
+
+                uint64_t bound = ((uint64_t)(power > peak ? power : peak) * tolerance) >> 8;
+                if ((uint64_t)miss > bound) {
+                    step = step / 2 < minStep ? minStep : step / 2;
+                } else if ((uint64_t)miss * 4 < bound) {
+                    step = step * 2 > maxStep ? maxStep : step * 2;
+                }
+            }
+            if (power > peak) peak = power;
+
+            x[0] = x[1];
+            p[0] = p[1];
+            x[1] = code;
+            p[1] = power;
+            if (known < 2) ++known;
+
+            advance();
+        }
+
+        /** Number of points measured in this sweep. */
+        uint16_t getCount(void) const { return count; }
+
+    private:
+        /** Move to the next code; spread the remaining budget if needed. */
+        void advance(void) {
+            if (code == end) {
+                done = true;
+                return;
+            }
+
+            uint16_t remaining = start < end ? end - code : code - end;
+            uint16_t pointsLeft = budget - count;
+            if (pointsLeft <= 1) {
+                code = end;
+                return;
+            }
+
+            /* Never plan on more points than the budget has left. */
+            uint16_t needed = remaining / (pointsLeft - 1);
+            uint16_t s = step < needed ? needed : step;
+            if (s >= remaining) {
+                code = end;
+            } else {
+                code = start < end ? code + s : code - s;
+            }
+        }
+
+        uint16_t minStep;
+        uint16_t maxStep;
+        uint16_t budget;
+        uint16_t tolerance;
+
+        uint16_t start;
+        uint16_t end;
+        uint16_t code;
+        uint16_t step;
+        uint16_t count;
+        uint8_t known;
+        bool done;
+        uint32_t peak;
+
+        /** The last two measured codes and their power, oldest first. */
+        uint16_t x[2];
+        uint32_t p[2];
+};
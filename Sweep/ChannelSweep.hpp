@@ -0,0 +1,160 @@
+/**
+ * @file ChannelSweep.hpp
+ * @brief Uniform sweep of every tracer channel at once, interleaved on
+ * the shared acquisition blocks.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Every block carries a [V, I] pair per channel for each trigger, so one
+ * block can settle one channel and sample another. Each channel walks
+ * the code table on its own: drop the block its DAC update straddles,
+ * settle, sample 1 << blockShift blocks, post the point and step. A
+ * channel that settles quickly moves ahead of a slow one instead of
+ * waiting for it, and the pass takes as long as the slowest channel
+ * rather than the sum of all of them. Points of different channels
+ * interleave in the stream and are told apart by Point::channel.
+ *
+ * Io is the board glue of SweepKernel and must also provide:
+ * - static const uint8_t MAX_CHANNELS.
+ * - uint8_t channels(void), the channels swept.
+ * - void setDac(uint8_t channel, uint16_t code).
+ * - void dropBlocks(void), dropping any block already completed.
+ * - const uint16_t *waitBlock(void), the next block, or nullptr if none
+ *   arrives in time.
+ * - uint8_t stride(void), codes per trigger in a block.
+ * - uint32_t blockPeriodUs(void), the time one block covers.
+ * - uint32_t settleLimit(void), the upper bound on the settle time in us.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "SettleDetector.hpp"
+#include "SweepKernel.hpp"
+#include "Acquisition/BlockSums.hpp"
+
+template <enum Mode M, class Io>
+class ChannelSweep {
+    public:
+        typedef SweepKernel<M, Io> Kernel;
+
+        /**
+         * @brief Sweep every channel over a code table. With adaptive set
+         * a channel samples once consecutive blocks agree by detector,
+         * otherwise (or at the latest) after settleLimit().
+         *
+         * @return false A block did not arrive; the pass is flushed as it is.
+         */
+        static bool sweep(Io &io, const DacTable &table, bool forward, const SettleDetector &detector, bool adaptive) {
+            Lane lanes[Io::MAX_CHANNELS];
+            uint8_t channels = io.channels();
+            uint8_t blocks = 1 << io.blockShift();
+            uint8_t stride = io.stride();
+            uint32_t period = io.blockPeriodUs();
+            uint32_t limitUs = io.settleLimit();
+            uint8_t active = 0;
+
+            for (uint8_t c = 0; c < channels; ++c) {
+                lanes[c].detector = detector;
+                lanes[c].step = 0;
+                if (table.size() == 0) {
+                    lanes[c].state = DONE;
+                } else {
+                    step(io, lanes[c], c, table.code(0, forward));
+                    ++active;
+                }
+            }
+            io.dropBlocks();
+
+            while (active > 0) {
+                const uint16_t *block = io.waitBlock();
+                if (block == nullptr) {
+                    io.flush();
+                    return false;
+                }
+
+                for (uint8_t c = 0; c < channels; ++c) {
+                    Lane &lane = lanes[c];
+                    const uint16_t *pairs = block + 2 * c;
+                    switch (lane.state) {
+                        case SKIP:
+                            /* The DAC update may fall inside this block. */
+                            lane.settledUs = period;
+                            lane.state = lane.settledUs < limitUs ? SETTLE : SAMPLE;
+                            break;
+                        case SETTLE: {
+                            lane.settledUs += period;
+                            bool settled = lane.settledUs >= limitUs;
+                            if (adaptive && !settled) {
+                                uint32_t v = 0;
+                                uint32_t i = 0;
+                                sumBlock<Io::BLOCK_PAIRS>(pairs, &v, &i, stride);
+                                settled = lane.detector.update(v, i);
+                            }
+                            if (settled) lane.state = SAMPLE;
+                            break;
+                        }
+                        case SAMPLE:
+                            accumulateBlock<Io::BLOCK_PAIRS>(pairs, &lane.moments, stride);
+                            if (++lane.sampled < blocks) break;
+
+                            io.post(finish(io, lane, c, table.code(lane.step, forward), !forward));
+                            if (++lane.step < table.size()) {
+                                step(io, lane, c, table.code(lane.step, forward));
+                            } else {
+                                lane.state = DONE;
+                                --active;
+                            }
+                            break;
+                        case DONE:
+                        default:
+                            break;
+                    }
+                }
+            }
+            io.flush();
+            return true;
+        }
+
+    private:
+        enum LaneState {
+            SKIP,
+            SETTLE,
+            SAMPLE,
+            DONE
+        };
+
+        /** Progress of one channel through the table. */
+        struct Lane {
+            SettleDetector detector;
+            enum LaneState state;
+            uint16_t step;
+            uint32_t settledUs;
+            uint8_t sampled;
+            Moments moments;
+        };
+
+        /** Drive a channel to its next code and start settling. */
+        static void step(Io &io, Lane &lane, uint8_t channel, uint16_t code) {
+            io.setDac(channel, code);
+            lane.detector.reset();
+            lane.state = SKIP;
+            lane.settledUs = 0;
+            lane.sampled = 0;
+            lane.moments = Moments();
+        }
+
+        static Point finish(Io &io, const Lane &lane, uint8_t channel, uint16_t code, bool reverse) {
+            Point point;
+            Kernel::reduce(lane.moments, io.blockShift(), &point);
+            point.sampleId = lane.step;
+            point.dacCode = code;
+            point.settleUs = lane.settledUs;
+            point.mode = M;
+            point.channel = channel;
+            point.reverse = reverse;
+            point.tick = io.clock();
+            point.timeUs = io.micros();
+            return point;
+        }
+};
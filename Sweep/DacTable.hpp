@@ -0,0 +1,56 @@
+/**
+ * @file DacTable.hpp
+ * @brief Table of the DAC codes a sweep visits, built once per profile.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Codes are stored in ascending order and read from either end, so the
+ * forward and reverse passes of a profile visit bit-identical codes and
+ * no pass accumulates a float step.
+ */
+
+#pragma once
+#include <stdint.h>
+
+class DacTable {
+    public:
+        static const uint16_t MAX_CODES = 1024;
+        static const uint16_t FULL_SCALE = 0xFFF;
+
+        DacTable(void) : count(0) {}
+
+        /**
+         * @brief Fill the table from start to end inclusive, every step
+         * codes. end is always the last entry, even if the range is not a
+         * whole number of steps.
+         *
+         * @return false The bounds are invalid or need more than MAX_CODES.
+         */
+        bool build(uint16_t start, uint16_t end, uint16_t step) {
+            count = 0;
+            if (step == 0 || start > end || end > FULL_SCALE) return false;
+            uint32_t needed = (uint32_t)(end - start + step - 1) / step + 1;
+            if (needed > MAX_CODES) return false;
+
+            for (uint32_t code = start; code < end; code += step) {
+                codes[count++] = code;
+            }
+            codes[count++] = end;
+            return true;
+        }
+
+        uint16_t size(void) const { return count; }
+
+        /** The k-th code of a pass in the given direction. */
+        uint16_t code(uint16_t k, bool forward) const {
+            return forward ? codes[k] : codes[count - 1 - k];
+        }
+
+        /** Ascending codes, for table driven hardware. */
+        const uint16_t *data(void) const { return codes; }
+
+    private:
+        uint16_t count;
+        uint16_t codes[MAX_CODES];
+};
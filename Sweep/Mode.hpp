@@ -0,0 +1,16 @@
+/**
+ * @file Mode.hpp
+ * @brief Test regimes. Each one selects the sensor scaling of the board.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+
+enum Mode {
+    CELL,
+    MODULE,
+    ARRAY,
+    NUM_MODES
+};
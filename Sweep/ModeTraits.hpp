@@ -0,0 +1,40 @@
+/**
+ * @file ModeTraits.hpp
+ * @brief Compile-time calibration defaults of each test regime.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The sweep grid is not here: bounds and step come from each profile at
+ * runtime. The calibration terms are the built-in ones, DEFAULT_CAL; they
+ * are functions so they stay constexpr without an out-of-line definition.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Calibration/Calibration.hpp"
+#include "Mode.hpp"
+
+template <enum Mode M>
+struct ModeTraits;
+
+/** Parameters shared by all regimes on this PCB. */
+struct BaseTraits {
+    static constexpr CalTerm dac(void) { return calTerm(9.9539, 0.0583, DAC_CODE_FULL_SCALE); }
+    static constexpr CalTerm current(void) { return calTerm(8.1169, 0.0, SENSOR_FULL_SCALE); }
+};
+
+template <>
+struct ModeTraits<CELL> : BaseTraits {
+    static constexpr CalTerm voltage(void) { return calTerm(1.1047, 0.0, SENSOR_FULL_SCALE); }
+};
+
+template <>
+struct ModeTraits<MODULE> : BaseTraits {
+    static constexpr CalTerm voltage(void) { return calTerm(5.4591, 0.0, SENSOR_FULL_SCALE); }
+};
+
+template <>
+struct ModeTraits<ARRAY> : BaseTraits {
+    static constexpr CalTerm voltage(void) { return calTerm(111.8247, 0.0, SENSOR_FULL_SCALE); }
+};
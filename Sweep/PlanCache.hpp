@@ -0,0 +1,102 @@
+/**
+ * @file PlanCache.hpp
+ * @brief Compiled sweep plans of the last few profiles, the least
+ * recently used given up first.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * A plan is what a sweep takes from its profile alone: the code table and
+ * the averaging and settle settings. Hosts queue the same few profiles
+ * over and over, one per module type, so a repeat finds its table filled
+ * and starts at once. Plans are keyed by a CRC-32 of the profile fields
+ * they follow from and the fields are compared on a match, so a collision
+ * only costs a rebuild. The sweep thread is the only user; a plan stays
+ * put until a later lookup evicts it, which is never during a pass.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "DacTable.hpp"
+#include "Profile.hpp"
+#include "Protocol/Crc.hpp"
+
+/** Everything a sweep pass needs that follows from its profile. */
+struct SweepPlan {
+    uint32_t key;               /* CRC-32 of the fields below. */
+    uint8_t mode;               /* enum Mode. */
+    uint16_t start;             /* DAC codes. */
+    uint16_t end;
+    uint16_t step;
+    uint8_t blockShift;         /* log2 of the acquisition blocks per point. */
+    uint32_t settleUs;          /* As in the profile; 0 for the default. */
+    DacTable table;
+};
+
+template <uint8_t N>
+class PlanCache {
+    public:
+        static_assert(N >= 1, "Keep at least one plan.");
+
+        PlanCache(void) : clock(0) {
+            for (uint8_t k = 0; k < N; ++k) used[k] = 0;
+        }
+
+        /**
+         * @brief The plan of a sweep profile, compiled in place of the
+         * least recently used one if it is not kept.
+         *
+         * @return nullptr The bounds do not make a code table.
+         */
+        const SweepPlan *find(const Profile &profile) {
+            uint32_t key = keyOf(profile);
+            uint8_t victim = 0;
+            for (uint8_t k = 0; k < N; ++k) {
+                if (used[k] != 0 && plans[k].key == key && matches(plans[k], profile)) {
+                    used[k] = ++clock;
+                    return &plans[k];
+                }
+                if (used[k] < used[victim]) victim = k;
+            }
+
+            SweepPlan &plan = plans[victim];
+            used[victim] = 0;
+            if (!plan.table.build(profile.start, profile.end, profile.step)) return nullptr;
+            plan.key = key;
+            plan.mode = profile.mode;
+            plan.start = profile.start;
+            plan.end = profile.end;
+            plan.step = profile.step;
+            plan.blockShift = profile.blockShift;
+            plan.settleUs = profile.settleUs;
+            used[victim] = ++clock;
+            return &plan;
+        }
+
+    private:
+        static uint32_t keyOf(const Profile &profile) {
+            uint8_t fields[12] = {
+                profile.mode,
+                (uint8_t)(profile.start >> 8), (uint8_t)profile.start,
+                (uint8_t)(profile.end >> 8), (uint8_t)profile.end,
+                (uint8_t)(profile.step >> 8), (uint8_t)profile.step,
+                profile.blockShift,
+                (uint8_t)(profile.settleUs >> 24), (uint8_t)(profile.settleUs >> 16),
+                (uint8_t)(profile.settleUs >> 8), (uint8_t)profile.settleUs
+            };
+            return crc32(fields, sizeof(fields));
+        }
+
+        static bool matches(const SweepPlan &plan, const Profile &profile) {
+            return plan.mode == profile.mode
+                && plan.start == profile.start
+                && plan.end == profile.end
+                && plan.step == profile.step
+                && plan.blockShift == profile.blockShift
+                && plan.settleUs == profile.settleUs;
+        }
+
+        SweepPlan plans[N];
+        uint32_t used[N];           /* Lookup count at last use; 0 for an empty slot. */
+        uint32_t clock;
+};
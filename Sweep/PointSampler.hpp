@@ -0,0 +1,81 @@
+/**
+ * @file PointSampler.hpp
+ * @brief Settles and samples one point from a stream of acquisition
+ * blocks.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Adc is the acquisition side of the board HAL and must provide:
+ * - static const uint16_t BLOCK_PAIRS, triggers per block.
+ * - uint8_t getStride(void), codes per trigger; the first [V, I] pair is
+ *   the channel sampled here.
+ * - void flush(void), dropping any block already completed.
+ * - const uint16_t *waitBlock(void), the next block, or nullptr if none
+ *   arrives in time.
+ * - uint32_t getBlockPeriodUs(void), the time one block covers.
+ * AdcDma provides it on the board; the host bench simulates it.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "Acquisition/BlockSums.hpp"
+#include "Pipeline/Point.hpp"
+#include "SettleDetector.hpp"
+
+template <class Adc>
+class PointSampler {
+    public:
+        PointSampler(Adc &adc, SettleDetector &detector) : adc(adc), detector(detector) {}
+
+        /**
+         * @brief Wait for the readings to settle after a DAC update. With
+         * adaptive set the wait ends once consecutive blocks agree,
+         * otherwise (or at the latest) after limitUs.
+         *
+         * @param settledUs The settle time used.
+         * @return false A block did not arrive.
+         */
+        bool settle(uint32_t limitUs, bool adaptive, uint32_t *settledUs) {
+            uint32_t settled = 0;
+
+            /* The first block may straddle the DAC update; always drop it. */
+            adc.flush();
+            if (adc.waitBlock() == nullptr) return false;
+            settled += adc.getBlockPeriodUs();
+
+            detector.reset();
+            while (settled < limitUs) {
+                const uint16_t *block = adc.waitBlock();
+                if (block == nullptr) return false;
+                settled += adc.getBlockPeriodUs();
+
+                if (adaptive) {
+                    uint32_t v = 0;
+                    uint32_t c = 0;
+                    sumBlock<Adc::BLOCK_PAIRS>(block, &v, &c, adc.getStride());
+                    if (detector.update(v, c)) break;
+                }
+            }
+            *settledUs = settled;
+            return true;
+        }
+
+        /**
+         * @brief Accumulate the raw codes of the next blocks.
+         *
+         * @return false A block did not arrive.
+         */
+        bool accumulate(uint8_t blocks, Moments *moments) {
+            for (uint8_t j = 0; j < blocks; ++j) {
+                const uint16_t *block = adc.waitBlock();
+                if (block == nullptr) return false;
+                accumulateBlock<Adc::BLOCK_PAIRS>(block, moments, adc.getStride());
+            }
+            return true;
+        }
+
+    private:
+        Adc &adc;
+        SettleDetector &detector;
+};
@@ -0,0 +1,193 @@
+/**
+ * @file Profile.hpp
+ * @brief A test profile requested by the PC, validated and converted to
+ * DAC codes.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The PC gives the sweep bounds and resolution as DAC output voltages in
+ * mV (0 - 3.3 V, before the gain stage on the PCB); they are converted
+ * to 12-bit codes once here, so the sweep only deals in codes. Batch
+ * profiles also set the averaging, the settle time bound and the number
+ * of pass pairs; plain profiles get the defaults. A stream profile logs
+ * the operating point at one code instead of sweeping; it holds start,
+ * or dithers around it by step when step is not 0. A link test profile
+ * sends synthetic records down the output paths instead, in turn with
+ * the other profiles so it has the link to itself.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "DacTable.hpp"
+#include "Mode.hpp"
+
+/** DAC reference voltage, mV. */
+static const uint16_t DAC_REF_MV = 3300;
+/** Most acquisition blocks averaged per point, as a power of two. */
+static const uint8_t MAX_BLOCK_SHIFT = 3;
+/** Resolution of the settle time of a batch profile. */
+static const uint16_t PROFILE_SETTLE_UNIT_US = 100;
+
+struct Profile {
+    uint16_t id;                /* Sequence number, assigned on arrival. */
+    uint8_t mode;               /* enum Mode. */
+    uint16_t start;             /* DAC codes. */
+    uint16_t end;
+    uint16_t step;
+    uint8_t blockShift;         /* log2 of the acquisition blocks per point. */
+    uint32_t settleUs;          /* Settle time bound per point; 0 for the default. */
+    uint8_t repeats;            /* Forward and reverse pass pairs. */
+    bool stream;                /* Log at start instead of sweeping. */
+    uint16_t rateHz;            /* Stream records per second. */
+    uint16_t durationS;         /* Stream length; 0 until stopped. */
+    bool linkTest;              /* Benchmark the output paths instead of sweeping. */
+    uint16_t testRecords;       /* Link test records per path. */
+    uint8_t testPaths;          /* Link test paths, a bit mask; see main.cpp. */
+};
+
+/** Reasons a profile is rejected, sent back as the exception error code. */
+enum ProfileStatus {
+    PROFILE_OK,
+    PROFILE_BAD_REGIME,
+    PROFILE_BAD_START,
+    PROFILE_BAD_END,
+    PROFILE_BAD_RANGE,
+    PROFILE_BAD_RESOLUTION,
+    PROFILE_BAD_OVERSAMPLING,
+    PROFILE_BAD_CRC,
+    PROFILE_QUEUE_FULL,
+    PROFILE_BAD_RATE,
+    PROFILE_BAD_RECORDS,
+    PROFILE_BAD_PATHS
+};
+
+/** A DAC output voltage in mV, to the nearest code. */
+inline uint16_t dacCode(uint32_t mv) {
+    return (uint16_t)((mv * DacTable::FULL_SCALE + DAC_REF_MV / 2) / DAC_REF_MV);
+}
+
+/**
+ * @brief Validate the fields of a profile frame and convert them.
+ *
+ * @param regime Test regime as sent: 1 cell, 2 module, 3 array.
+ * @param startMv, endMv, resolutionMv Sweep bounds and step, mV.
+ */
+inline enum ProfileStatus makeProfile(
+    uint8_t regime,
+    uint16_t startMv,
+    uint16_t endMv,
+    uint16_t resolutionMv,
+    Profile *profile
+) {
+    if (regime < 1 || regime > NUM_MODES) return PROFILE_BAD_REGIME;
+    if (startMv > DAC_REF_MV) return PROFILE_BAD_START;
+    if (endMv > DAC_REF_MV) return PROFILE_BAD_END;
+    if (startMv > endMv) return PROFILE_BAD_RANGE;
+    if (resolutionMv == 0 || resolutionMv > 1000) return PROFILE_BAD_RESOLUTION;
+
+    profile->id = 0;
+    profile->mode = regime - 1;
+    profile->blockShift = 0;
+    profile->settleUs = 0;
+    profile->repeats = 1;
+    profile->stream = false;
+    profile->rateHz = 0;
+    profile->durationS = 0;
+    profile->linkTest = false;
+    profile->testRecords = 0;
+    profile->testPaths = 0;
+    profile->start = dacCode(startMv);
+    profile->end = dacCode(endMv);
+    profile->step = dacCode(resolutionMv);
+    if (profile->step == 0) profile->step = 1;
+
+    /* Must fit in one code table. */
+    if ((uint32_t)(profile->end - profile->start) / profile->step + 2 > DacTable::MAX_CODES) {
+        return PROFILE_BAD_RESOLUTION;
+    }
+    return PROFILE_OK;
+}
+
+/**
+ * @brief Validate and apply the batch fields of a profile.
+ *
+ * @param blockShift log2 of the acquisition blocks averaged per point.
+ * @param settle Settle time bound in PROFILE_SETTLE_UNIT_US; 0 for the default.
+ * @param repeats Forward and reverse pass pairs; 0 is taken as 1.
+ */
+inline enum ProfileStatus setBatch(uint8_t blockShift, uint8_t settle, uint8_t repeats, Profile *profile) {
+    if (blockShift > MAX_BLOCK_SHIFT) return PROFILE_BAD_OVERSAMPLING;
+    profile->blockShift = blockShift;
+    profile->settleUs = (uint32_t)settle * PROFILE_SETTLE_UNIT_US;
+    profile->repeats = repeats == 0 ? 1 : repeats;
+    return PROFILE_OK;
+}
+
+/**
+ * @brief Validate the fields of a stream request and convert them.
+ *
+ * @param regime Test regime as sent: 1 cell, 2 module, 3 array.
+ * @param dacMv DAC output voltage to hold, or to start dithering from.
+ * @param ditherMv Perturb and observe step; 0 holds dacMv.
+ * @param rateHz Records per second, up to maxRateHz.
+ * @param durationS Stream length; 0 until stopped.
+ */
+inline enum ProfileStatus makeStream(
+    uint8_t regime,
+    uint16_t dacMv,
+    uint8_t ditherMv,
+    uint16_t rateHz,
+    uint16_t durationS,
+    uint16_t maxRateHz,
+    Profile *profile
+) {
+    if (regime < 1 || regime > NUM_MODES) return PROFILE_BAD_REGIME;
+    if (dacMv > DAC_REF_MV) return PROFILE_BAD_START;
+    if (rateHz == 0 || rateHz > maxRateHz) return PROFILE_BAD_RATE;
+
+    profile->id = 0;
+    profile->mode = regime - 1;
+    profile->start = dacCode(dacMv);
+    profile->end = profile->start;
+    profile->step = dacCode(ditherMv);
+    if (ditherMv != 0 && profile->step == 0) profile->step = 1;
+    profile->blockShift = 0;
+    profile->settleUs = 0;
+    profile->repeats = 1;
+    profile->stream = true;
+    profile->rateHz = rateHz;
+    profile->durationS = durationS;
+    profile->linkTest = false;
+    profile->testRecords = 0;
+    profile->testPaths = 0;
+    return PROFILE_OK;
+}
+
+/**
+ * @brief Validate the fields of a link test request and convert them.
+ *
+ * @param records Synthetic records per path, at least 1.
+ * @param paths Bit mask of the paths to test, of allPaths; 0 for all.
+ * A non-zero mask with none of them is refused.
+ */
+inline enum ProfileStatus makeLinkTest(uint16_t records, uint8_t paths, uint8_t allPaths, Profile *profile) {
+    if (records == 0) return PROFILE_BAD_RECORDS;
+    if (paths != 0 && (paths & allPaths) == 0) return PROFILE_BAD_PATHS;
+
+    profile->id = 0;
+    profile->mode = MODULE;
+    profile->start = 0;
+    profile->end = 0;
+    profile->step = 0;
+    profile->blockShift = 0;
+    profile->settleUs = 0;
+    profile->repeats = 1;
+    profile->stream = false;
+    profile->rateHz = 0;
+    profile->durationS = 0;
+    profile->linkTest = true;
+    profile->testRecords = records;
+    profile->testPaths = paths == 0 ? allPaths : paths & allPaths;
+    return PROFILE_OK;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file SettleDetector.hpp
+ * @brief Decides when the sensor readings have settled after a DAC update
+ * by comparing consecutive acquisition blocks.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+#include <stdint.h>
+
+class SettleDetector {
+    public:
+        /**
+         * @param tolerance Largest change in the sum of a block, per
+         * channel, that still counts as settled.
+         * @param matches Number of consecutive settled block pairs needed.
+         */
+        SettleDetector(uint32_t tolerance, uint8_t matches) :
+            tolerance(tolerance),
+            matches(matches),
+            count(0),
+            primed(false),
+            lastVolt(0),
+            lastCurr(0) {}
+
+        /** Settled only on identical blocks; assign a configured detector before use. */
+        SettleDetector(void) : SettleDetector(0, 1) {}
+
+        /** Forget the previous blocks; call after every DAC update. */
+        void reset(void) {
+            count = 0;
+            primed = false;
+        }
+
+        /**
+         * @brief Feed the sums of the next block.
+         *
+         * @return true The last matches blocks agree within tolerance.
+         */
+        bool update(uint32_t voltSum, uint32_t currSum) {
+            if (primed && distance(voltSum, lastVolt) <= tolerance && distance(currSum, lastCurr) <= tolerance) {
+                if (count < matches) ++count;
+            } else {
+                count = 0;
+            }
+            primed = true;
+            lastVolt = voltSum;
+            lastCurr = currSum;
+            return count >= matches;
+        }
+
+    private:
+        static uint32_t distance(uint32_t a, uint32_t b) { return a > b ? a - b : b - a; }
+
+        uint32_t tolerance;
+        uint8_t matches;
+        uint8_t count;
+        bool primed;
+        uint32_t lastVolt;
+        uint32_t lastCurr;
+};
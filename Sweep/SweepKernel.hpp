@@ -0,0 +1,139 @@
+/**
+ * @file SweepKernel.hpp
+ * @brief Sweep loops specialized at compile time for one test regime.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The regime never changes within a sweep, so it is dispatched to a
+ * template parameter once per pass rather than switched on per sample;
+ * within the kernel it only stamps the points. The grid comes from the
+ * profile's DacTable. Points leave as raw codes; they are calibrated with
+ * the per-board tables on the transmit thread. The blocks averaged per
+ * point are set per profile as a power of two, so the mean of a point is
+ * still a shift. Forward and reverse passes share one loop and read the same
+ * DacTable from either end, so they visit exactly the same DAC codes.
+ *
+ * Io is the board glue and must provide:
+ * - static const uint16_t BLOCK_PAIRS, pairs per acquisition block.
+ * - static const uint8_t CODE_SHIFT, left shift taking a raw code to Q12.4.
+ * - uint8_t blockShift(void), log2 of the acquisition blocks per point.
+ * - void setDac(uint16_t code).
+ * - uint32_t sample(uint8_t blocks, Moments *moments), settling and
+ *   accumulating raw codes; returns the settle time in us.
+ * - uint32_t clock(void), the acquisition block count.
+ * - uint32_t micros(void), the device time in us, low 32 bits.
+ * - void post(const Point &point) and void flush(void), the sweep output.
+ * - bool aborted(void), a fault has cut the pass short; the point being
+ *   measured is dropped and the pass flushed as it is.
+ * - uint32_t sequence(const DacTable &table, bool forward, uint8_t blocks),
+ *   starting a hardware timed run over a code table; returns the fixed
+ *   settle time per step in us, or 0 if the run could not start.
+ * - bool collect(RawPoint *point), the next point of the timed run.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "AdaptiveStepper.hpp"
+#include "DacTable.hpp"
+#include "Mode.hpp"
+#include "Analysis/Noise.hpp"
+#include "Pipeline/Point.hpp"
+
+template <enum Mode M, class Io>
+class SweepKernel {
+    public:
+        static_assert((Io::BLOCK_PAIRS & (Io::BLOCK_PAIRS - 1)) == 0, "BLOCK_PAIRS must be a power of two.");
+
+        /** log2 of n, for powers of two. */
+        static constexpr uint8_t log2(uint32_t n) { return n <= 1 ? 0 : 1 + log2(n / 2); }
+
+        /** Mean in Q12.4 of the raw codes of 1 << blockShift blocks. */
+        static uint16_t mean(uint32_t sum, uint8_t blockShift) {
+            return (uint16_t)((sum << Io::CODE_SHIFT) >> (log2(Io::BLOCK_PAIRS) + blockShift));
+        }
+
+        /** Fill in the means and RMS noise of a point from its raw sums. */
+        static void reduce(const Moments &moments, uint8_t blockShift, Point *point) {
+            uint32_t samples = (uint32_t)Io::BLOCK_PAIRS << blockShift;
+            point->volt = mean(moments.voltSum, blockShift);
+            point->curr = mean(moments.currSum, blockShift);
+            point->voltNoise = rmsNoise(moments.voltSum, moments.voltSq, samples, Io::CODE_SHIFT);
+            point->currNoise = rmsNoise(moments.currSum, moments.currSq, samples, Io::CODE_SHIFT);
+        }
+
+        /** Set the DAC, settle and sample one point. */
+        static Point measure(Io &io, uint16_t code, uint16_t sampleId) {
+            Moments moments = {};
+            Point point;
+            uint8_t blockShift = io.blockShift();
+
+            io.setDac(code);
+            point.settleUs = io.sample(1 << blockShift, &moments);
+            point.sampleId = sampleId;
+            point.dacCode = code;
+            reduce(moments, blockShift, &point);
+            point.mode = M;
+            point.channel = 0;
+            point.reverse = false;
+            point.tick = io.clock();
+            point.timeUs = io.micros();
+            return point;
+        }
+
+        /** Uniform sweep over a code table. */
+        static void sweep(Io &io, const DacTable &table, bool forward) {
+            for (uint16_t k = 0; k < table.size(); ++k) {
+                Point point = measure(io, table.code(k, forward), k);
+                if (io.aborted()) break;
+                point.reverse = !forward;
+                io.post(point);
+            }
+            io.flush();
+        }
+
+        /** Sweep between the bounds of a code table, refining around the knee. */
+        static void sweepAdaptive(Io &io, AdaptiveStepper &stepper, const DacTable &table, bool forward) {
+            uint16_t sampleId = 0;
+            uint16_t code;
+
+            stepper.begin(table.code(0, forward), table.code(0, !forward));
+            while (stepper.next(&code)) {
+                Point point = measure(io, code, sampleId++);
+                if (io.aborted()) break;
+                stepper.update(point.volt, point.curr);
+                point.reverse = !forward;
+                io.post(point);
+            }
+            io.flush();
+        }
+
+        /**
+         * Uniform sweep over a code table, with the DAC stepped from the
+         * acquisition interrupt for repeatable point timing.
+         */
+        static void sweepTimed(Io &io, const DacTable &table, bool forward) {
+            uint8_t blockShift = io.blockShift();
+            uint32_t settleUs = io.sequence(table, forward, 1 << blockShift);
+            if (settleUs == 0) {
+                io.flush();
+                return;
+            }
+
+            RawPoint raw;
+            while (io.collect(&raw)) {
+                Point point;
+                point.sampleId = raw.index;
+                point.dacCode = table.code(raw.index, forward);
+                reduce(raw.sums, blockShift, &point);
+                point.settleUs = settleUs;
+                point.mode = M;
+                point.channel = 0;
+                point.reverse = !forward;
+                point.tick = raw.tick;
+                point.timeUs = raw.timeUs;
+                io.post(point);
+            }
+            io.flush();
+        }
+};
@@ -0,0 +1,175 @@
+/**
+ * @file BenchBoard.hpp
+ * @brief Simulated board HAL for the host bench: an acquisition stream
+ * fed by a panel model, and the Io glue of the sweep kernels.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * The DAC sets the terminal voltage of the panel, linearly between the
+ * sweep bounds; it follows each DAC step as a first order lag and the
+ * current follows the curve. Blocks are produced on demand, so the bench
+ * runs as fast as the host allows while keeping count of the time the
+ * board would have spent. Codes are made by inverting the calibration of
+ * the regime, with Gaussian noise on every conversion.
+ */
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Calibration/Calibration.hpp"
+#include "Pipeline/Point.hpp"
+#include "Sweep/DacTable.hpp"
+#include "Sweep/PointSampler.hpp"
+#include "PanelModel.hpp"
+
+struct BenchConfig {
+    uint32_t pairRate;          /* Hz. */
+    uint16_t oversampling;      /* Conversions per delivered sample. */
+    double tauUs;               /* Time constant of the response to a DAC step. */
+    double noise;               /* RMS noise per conversion, 12-bit codes. */
+    uint16_t dacLow;            /* DAC code at 0 V. */
+    uint16_t dacHigh;           /* DAC code at Voc. */
+    uint16_t settleTolerance;   /* Codes, as SETTLE_TOLERANCE. */
+};
+
+class BenchAdc {
+    public:
+        static const uint16_t BLOCK_PAIRS = 64;
+
+        BenchAdc(const PanelModel &panel, const CalTable &cal, const BenchConfig &config, uint8_t codeShift) :
+            panel(panel),
+            cal(cal),
+            config(config),
+            codeShift(codeShift),
+            rng(1),
+            gauss(0.0, 1.0),
+            volt(0.0),
+            target(0.0),
+            alpha(1.0 - std::exp(-1e6 / config.pairRate / config.tauUs)),
+            blockPeriodUs((uint32_t)((uint64_t)BLOCK_PAIRS * 1000000 / config.pairRate)),
+            blockCount(0),
+            elapsedUs(0),
+            idealUs(0.0) {}
+
+        /** Step the terminal voltage and work out how long it takes to settle. */
+        void setDac(uint16_t code) {
+            double span = (double)(config.dacHigh - config.dacLow);
+            double t = ((double)code - config.dacLow) / span;
+            target = panel.voc() * (t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t);
+
+            /* Both channels within tolerance, in 12-bit codes of the mean. */
+            double dv = std::fabs(voltCode(target) - voltCode(volt)) / 16.0;
+            double di = std::fabs(currCode(panel.current(target)) - currCode(panel.current(volt))) / 16.0;
+            double step = dv > di ? dv : di;
+            idealUs = step > config.settleTolerance ? config.tauUs * std::log(step / config.settleTolerance) : 0.0;
+        }
+
+        void flush(void) {}
+
+        const uint16_t *waitBlock(void) {
+            double scale = codeShift == 0 ? 16.0 / std::sqrt((double)config.oversampling) : 1.0;
+            for (uint16_t k = 0; k < BLOCK_PAIRS; ++k) {
+                volt += (target - volt) * alpha;
+                block[2 * k] = sample(voltCode(volt), scale);
+                block[2 * k + 1] = sample(currCode(panel.current(volt)), scale);
+            }
+            ++blockCount;
+            elapsedUs += blockPeriodUs;
+            return block;
+        }
+
+        uint32_t getBlockPeriodUs(void) const { return blockPeriodUs; }
+        uint8_t getStride(void) const { return 2; }
+        uint32_t getBlockCount(void) const { return blockCount; }
+        /** Board time so far. */
+        uint64_t getElapsedUs(void) const { return elapsedUs; }
+        /** Time the last DAC step needed to settle within tolerance. */
+        double getIdealUs(void) const { return idealUs; }
+
+    private:
+        /** Q12.4 code of a voltage or current, inverting the calibration. */
+        double voltCode(double mv) const { return (mv - cal.voltage.offset) * 65536.0 / cal.voltage.gain; }
+        double currCode(double ma) const { return (ma - cal.current.offset) * 65536.0 / cal.current.gain; }
+
+        /** A delivered sample: 12-bit, or Q12.4 when oversampled. */
+        uint16_t sample(double q, double scale) {
+            double code = (codeShift == 0 ? q : q / 16.0) + gauss(rng) * config.noise * scale;
+            double full = codeShift == 0 ? SENSOR_FULL_SCALE : 0xFFF;
+            code = code < 0.0 ? 0.0 : code > full ? full : code;
+            return (uint16_t)(code + 0.5);
+        }
+
+        const PanelModel &panel;
+        const CalTable &cal;
+        BenchConfig config;
+        uint8_t codeShift;
+        std::mt19937 rng;
+        std::normal_distribution<double> gauss;
+        double volt;                /* Terminal voltage, mV. */
+        double target;
+        double alpha;               /* Lag per pair period. */
+        uint32_t blockPeriodUs;
+        uint32_t blockCount;
+        uint64_t elapsedUs;
+        double idealUs;
+        uint16_t block[2 * BLOCK_PAIRS];
+};
+
+/** Io of the sweep kernels, as BoardIo in main.cpp. */
+template <uint8_t SHIFT>
+struct BenchIo {
+    static const uint16_t BLOCK_PAIRS = BenchAdc::BLOCK_PAIRS;
+    static const uint8_t CODE_SHIFT = SHIFT;
+
+    BenchIo(BenchAdc &adc, PointSampler<BenchAdc> &sampler, bool adaptiveSettle, uint32_t settleUs) :
+        adc(adc),
+        sampler(sampler),
+        adaptiveSettle(adaptiveSettle),
+        settleUs(settleUs),
+        shift(0),
+        passes(0),
+        usedUs(0.0),
+        idealUs(0.0),
+        premature(0) {}
+
+    uint8_t blockShift(void) { return shift; }
+    void setDac(uint16_t code) { adc.setDac(code); }
+    uint32_t sample(uint8_t blocks, Moments *moments) {
+        uint32_t settled = 0;
+        if (!sampler.settle(settleUs, adaptiveSettle, &settled)) std::abort();
+        if (!sampler.accumulate(blocks, moments)) std::abort();
+
+        usedUs += settled;
+        idealUs += adc.getIdealUs();
+        if (settled < adc.getIdealUs()) ++premature;
+        return settled;
+    }
+    uint32_t clock(void) { return adc.getBlockCount(); }
+    uint32_t micros(void) { return (uint32_t)adc.getElapsedUs(); }
+    void post(const Point &point) { points.push_back(point); }
+    bool aborted(void) { return false; }
+    void flush(void) {
+        passEnds.push_back(points.size());
+        ++passes;
+    }
+    /* No sequencer on the host. */
+    uint32_t sequence(const DacTable &table, bool forward, uint8_t blocks) { return 0; }
+    bool collect(RawPoint *point) { return false; }
+
+    BenchAdc &adc;
+    PointSampler<BenchAdc> &sampler;
+    bool adaptiveSettle;
+    uint32_t settleUs;
+    uint8_t shift;
+
+    std::vector<Point> points;
+    std::vector<size_t> passEnds;   /* Point count at the end of each pass. */
+    uint32_t passes;
+    double usedUs;                  /* Settle time used, summed. */
+    double idealUs;                 /* Settle time needed, summed. */
+    uint32_t premature;             /* Points sampled before settling. */
+};
@@ -0,0 +1,92 @@
+/**
+ * @file PanelModel.hpp
+ * @brief IV curves for the host bench: a single diode model, or a curve
+ * recorded with __DEBUG_CSV__.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+class PanelModel {
+    public:
+        virtual ~PanelModel(void) {}
+
+        /** Current at a terminal voltage, mA; voltages in mV. */
+        virtual double current(double mv) const = 0;
+        virtual double voc(void) const = 0;
+
+        /** True maximum power point, mW, from a dense scan. */
+        double pmax(void) const {
+            double best = 0.0;
+            for (double mv = 0.0; mv <= voc(); mv += voc() / 4096.0) {
+                best = std::max(best, mv * current(mv) / 1000.0);
+            }
+            return best;
+        }
+};
+
+/** I = Isc - I0 (exp(V / a) - 1), with I0 such that I(Voc) = 0. */
+class DiodeModel : public PanelModel {
+    public:
+        /** @param a Modified ideality factor n Ns Vt, mV. */
+        DiodeModel(double iscMa, double vocMv, double a) : isc(iscMa), open(vocMv), a(a) {
+            i0 = isc / (std::exp(open / a) - 1.0);
+        }
+
+        double current(double mv) const override {
+            return std::max(0.0, isc - i0 * (std::exp(mv / a) - 1.0));
+        }
+        double voc(void) const override { return open; }
+
+    private:
+        double isc;
+        double open;
+        double a;
+        double i0;
+};
+
+/**
+ * A curve from the CSV stream: Gate (V), Voltage (V), Current (A), then
+ * anything. Lines that do not start with a number (headers, summaries)
+ * are skipped; the current is interpolated between the recorded points.
+ */
+class RecordedModel : public PanelModel {
+    public:
+        /** @return false The file has fewer than two points. */
+        bool load(const char *path) {
+            FILE *file = std::fopen(path, "r");
+            if (file == nullptr) return false;
+
+            char line[256];
+            while (std::fgets(line, sizeof(line), file) != nullptr) {
+                double gate, volt, curr;
+                if (std::sscanf(line, "%lf,%lf,%lf", &gate, &volt, &curr) != 3) continue;
+                points.push_back(std::make_pair(volt * 1000.0, std::max(0.0, curr * 1000.0)));
+            }
+            std::fclose(file);
+            std::sort(points.begin(), points.end());
+            return points.size() >= 2;
+        }
+
+        double current(double mv) const override {
+            if (mv <= points.front().first) return points.front().second;
+            if (mv >= points.back().first) return 0.0;
+            auto upper = std::lower_bound(points.begin(), points.end(), std::make_pair(mv, 0.0));
+            auto lower = upper - 1;
+            double t = (mv - lower->first) / (upper->first - lower->first);
+            return lower->second + t * (upper->second - lower->second);
+        }
+        double voc(void) const override { return points.back().first; }
+
+    private:
+        std::vector<std::pair<double, double>> points;
+};
@@ -0,0 +1,277 @@
+/**
+ * @file bench.cpp
+ * @brief Host bench of the sweep kernels, calibration and encoders.
+ * @version 0.1
+ * @date 2026-10-14
+ * @copyright Copyright (c) 2026
+ * @note
+ * Runs every combination of stepping (uniform, adaptive) and settling
+ * (adaptive, fixed) against a panel model and reports, per combination:
+ * - the points per second the acquisition allows, in board time,
+ * - the settle efficiency, the settle time the model needed over the
+ *   time used, and the points sampled before they had settled,
+ * - the bytes per point and link bound points per second of the point
+ *   frames, the delta blocks and the CAN frames,
+ * - the error of the extracted maximum power against the model,
+ * - the host time per point, to catch regressions in the code itself.
+ *
+ * Usage: pv_bench [--regime cell|module|array] [--curve FILE.csv]
+ *                 [--tau US] [--noise CODES] [--oversampling 1|16]
+ *                 [--baud BITS] [--passes N]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "Analysis/CurveExtractor.hpp"
+#include "Calibration/Calibration.hpp"
+#include "Protocol/DeltaFrame.hpp"
+#include "Protocol/Frame.hpp"
+#include "Sweep/AdaptiveStepper.hpp"
+#include "Sweep/DacTable.hpp"
+#include "Sweep/SweepKernel.hpp"
+#include "BenchBoard.hpp"
+#include "PanelModel.hpp"
+
+/** As in main.cpp. */
+#define SETTLING_TIME           15000 // us
+#define SETTLE_TOLERANCE        2 // ADC codes
+#define SETTLE_MATCHES          2
+#define SAMPLE_RATE             50000 // Hz
+#define CAN_RATE                100000 // bits/s
+#define STEP_MIN                2
+#define STEP_MAX                64
+#define STEP_BUDGET             64
+#define STEP_TOLERANCE          3
+
+/** Default grid, in DAC codes; the firmware takes it from each profile. */
+#define SWEEP_START             1024 // 0.25 of DAC full scale.
+#define SWEEP_END               2048 // 0.5 of DAC full scale.
+#define SWEEP_STEP              4
+
+#define CAN_FRAME_BITS          111 // 8 data bytes, standard ID, no stuffing.
+#define UART_BITS_PER_BYTE      10
+
+struct Options {
+    enum Mode mode = MODULE;
+    const char *curve = nullptr;
+    double tauUs = 2000.0;
+    double noise = 1.5;
+    uint16_t oversampling = 16;
+    uint32_t baud = 921600;
+    uint8_t passes = 2;
+};
+
+struct Result {
+    uint32_t points;
+    double acquisitionRate;     /* Points/s, board time. */
+    double settleEfficiency;
+    uint32_t premature;
+    double pointBytes;          /* Per point, including the summaries. */
+    double deltaBytes;
+    double canFrames;
+    double pmaxError;           /* Relative, over all passes. */
+    double hostUs;              /* Per point. */
+};
+
+/** Bytes of the delta blocks of one pass, in batches as the pipeline makes them. */
+static uint32_t deltaSize(const std::vector<Point> &points, size_t first, size_t end) {
+    uint8_t frame[Frame::deltaMaxSize(16)];
+    uint32_t bytes = 0;
+    for (size_t k = first; k < end; k += 16) {
+        Frame::DeltaEncoder encoder;
+        encoder.begin(frame, points[k].mode, points[k].sampleId);
+        for (size_t j = k; j < end && j < k + 16; ++j) {
+            encoder.add(points[j].dacCode, points[j].volt, points[j].curr, points[j].timeUs);
+        }
+        bytes += encoder.seal();
+    }
+    return bytes;
+}
+
+template <enum Mode M, uint8_t SHIFT>
+static Result run(const Options &options, const PanelModel &panel, bool adaptiveStep, bool adaptiveSettle) {
+    typedef SweepKernel<M, BenchIo<SHIFT>> Kernel;
+
+    BenchConfig config = {
+        SAMPLE_RATE,
+        options.oversampling,
+        options.tauUs,
+        options.noise,
+        SWEEP_START,
+        SWEEP_END,
+        SETTLE_TOLERANCE
+    };
+    const CalTable &cal = DEFAULT_CAL[M];
+    BenchAdc adc(panel, cal, config, SHIFT);
+    SettleDetector detector((SETTLE_TOLERANCE * BenchAdc::BLOCK_PAIRS) << (4 - SHIFT), SETTLE_MATCHES);
+    PointSampler<BenchAdc> sampler(adc, detector);
+    BenchIo<SHIFT> io(adc, sampler, adaptiveSettle, SETTLING_TIME);
+    AdaptiveStepper stepper(STEP_MIN, STEP_MAX, STEP_BUDGET, STEP_TOLERANCE);
+    DacTable table;
+    if (!table.build(SWEEP_START, SWEEP_END, SWEEP_STEP)) std::exit(1);
+
+    auto started = std::chrono::steady_clock::now();
+    for (uint8_t pass = 0; pass < 2 * options.passes; ++pass) {
+        bool forward = (pass & 1) == 0;
+        if (adaptiveStep) {
+            Kernel::sweepAdaptive(io, stepper, table, forward);
+        } else {
+            Kernel::sweep(io, table, forward);
+        }
+    }
+    double hostUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+
+    /* Calibrate and extract each pass as the transmit thread does. */
+    Result result = {};
+    double truePmax = panel.pmax();
+    uint32_t deltaBytes = 0;
+    size_t first = 0;
+    for (size_t end : io.passEnds) {
+        CurveExtractor extractor;
+        for (size_t k = first; k < end; ++k) {
+            const Point &point = io.points[k];
+            extractor.update(calibrate(cal, point.dacCode, point.volt, point.curr));
+        }
+        CurveSummary summary = extractor.finish();
+        result.pmaxError += std::fabs(summary.pmax - truePmax) / truePmax;
+        deltaBytes += deltaSize(io.points, first, end) + Frame::SUMMARY_SIZE;
+        first = end;
+    }
+
+    uint32_t passes = io.passEnds.size();
+    result.points = io.points.size();
+    result.acquisitionRate = result.points / (adc.getElapsedUs() / 1e6);
+    result.settleEfficiency = io.usedUs > 0 ? io.idealUs / io.usedUs : 0.0;
+    result.premature = io.premature;
+    result.pointBytes = (double)(result.points * Frame::POINT_SIZE + passes * Frame::SUMMARY_SIZE) / result.points;
+    result.deltaBytes = (double)deltaBytes / result.points;
+    result.canFrames = (double)(result.points + 2 * passes) / result.points;
+    result.pmaxError /= passes;
+    result.hostUs = hostUs / result.points;
+    return result;
+}
+
+template <enum Mode M>
+static Result runMode(const Options &options, const PanelModel &panel, bool adaptiveStep, bool adaptiveSettle) {
+    if (options.oversampling >= 16) return run<M, 0>(options, panel, adaptiveStep, adaptiveSettle);
+    return run<M, 4>(options, panel, adaptiveStep, adaptiveSettle);
+}
+
+static Result runAny(const Options &options, const PanelModel &panel, bool adaptiveStep, bool adaptiveSettle) {
+    switch (options.mode) {
+        case CELL:
+            return runMode<CELL>(options, panel, adaptiveStep, adaptiveSettle);
+        case ARRAY:
+            return runMode<ARRAY>(options, panel, adaptiveStep, adaptiveSettle);
+        case MODULE:
+        default:
+            return runMode<MODULE>(options, panel, adaptiveStep, adaptiveSettle);
+    }
+}
+
+/** Default curve of a regime: Voc at 0.8 and Isc at 0.6 of sensor full scale. */
+static DiodeModel defaultPanel(enum Mode mode) {
+    const CalTable &cal = DEFAULT_CAL[mode];
+    double voc = 0.8 * cal.voltage.apply(SENSOR_FULL_SCALE);
+    double isc = 0.6 * cal.current.apply(SENSOR_FULL_SCALE);
+    return DiodeModel(isc, voc, voc / 15.0);
+}
+
+static void usage(void) {
+    std::fprintf(
+        stderr,
+        "usage: pv_bench [--regime cell|module|array] [--curve FILE.csv] [--tau US]\n"
+        "                [--noise CODES] [--oversampling 1|16] [--baud BITS] [--passes N]\n"
+    );
+    std::exit(2);
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int k = 1; k < argc; ++k) {
+        if (k + 1 >= argc) usage();
+        const char *value = argv[k + 1];
+        if (!std::strcmp(argv[k], "--regime")) {
+            if (!std::strcmp(value, "cell")) options.mode = CELL;
+            else if (!std::strcmp(value, "module")) options.mode = MODULE;
+            else if (!std::strcmp(value, "array")) options.mode = ARRAY;
+            else usage();
+        } else if (!std::strcmp(argv[k], "--curve")) {
+            options.curve = value;
+        } else if (!std::strcmp(argv[k], "--tau")) {
+            options.tauUs = std::atof(value);
+        } else if (!std::strcmp(argv[k], "--noise")) {
+            options.noise = std::atof(value);
+        } else if (!std::strcmp(argv[k], "--oversampling")) {
+            options.oversampling = (uint16_t)std::atoi(value);
+        } else if (!std::strcmp(argv[k], "--baud")) {
+            options.baud = (uint32_t)std::atol(value);
+        } else if (!std::strcmp(argv[k], "--passes")) {
+            options.passes = (uint8_t)std::atoi(value);
+        } else {
+            usage();
+        }
+        ++k;
+    }
+    if (options.tauUs <= 0.0 || options.passes == 0 || options.baud == 0) usage();
+
+    std::unique_ptr<PanelModel> panel;
+    if (options.curve != nullptr) {
+        RecordedModel *recorded = new RecordedModel();
+        panel.reset(recorded);
+        if (!recorded->load(options.curve)) {
+            std::fprintf(stderr, "pv_bench: cannot read a curve from %s\n", options.curve);
+            return 1;
+        }
+    } else {
+        panel.reset(new DiodeModel(defaultPanel(options.mode)));
+    }
+
+    std::printf(
+        "Voc %.0f mV, Pmax %.0f mW, tau %.0f us, noise %.1f codes, oversampling %u, %u baud\n\n",
+        panel->voc(),
+        panel->pmax(),
+        options.tauUs,
+        options.noise,
+        options.oversampling,
+        options.baud
+    );
+    std::printf(
+        "%-8s %-8s %6s %8s %7s %6s | %6s %8s | %6s %8s | %8s | %7s %7s\n",
+        "step", "settle", "points", "acq/s", "eff", "early",
+        "B/pt", "pt/s", "dB/pt", "dpt/s", "can pt/s", "Pmax", "host us"
+    );
+
+    double serialBytes = (double)options.baud / UART_BITS_PER_BYTE;
+    double canRate = (double)CAN_RATE / CAN_FRAME_BITS;
+    for (int c = 0; c < 4; ++c) {
+        bool adaptiveStep = c >= 2;
+        bool adaptiveSettle = (c & 1) == 0;
+        Result r = runAny(options, *panel, adaptiveStep, adaptiveSettle);
+
+        /* Each stream is bound by whichever of acquisition and link is slower. */
+        double pointRate = std::min(r.acquisitionRate, serialBytes / r.pointBytes);
+        double deltaRate = std::min(r.acquisitionRate, serialBytes / r.deltaBytes);
+        double rateOnCan = std::min(r.acquisitionRate, canRate / r.canFrames);
+        std::printf(
+            "%-8s %-8s %6u %8.1f %6.1f%% %6u | %6.2f %8.1f | %6.2f %8.1f | %8.1f | %6.2f%% %7.2f\n",
+            adaptiveStep ? "adaptive" : "uniform",
+            adaptiveSettle ? "adaptive" : "fixed",
+            r.points,
+            r.acquisitionRate,
+            100.0 * r.settleEfficiency,
+            r.premature,
+            r.pointBytes,
+            pointRate,
+            r.deltaBytes,
+            deltaRate,
+            rateOnCan,
+            100.0 * r.pmaxError,
+            r.hostUs
+        );
+    }
+    return 0;
+}
@@ -6,157 +6,1841 @@
  * @date 2021-09-23
  * @copyright Copyright (c) 2021
  * @note
- * Modify __DEBUG_TUNING__ to true to switch to manual calibration 
- * mode. Modify the controller sections to optimize resolution and
- * breadth of the sampling scheme. Serial baud rate is 19200 bits 
- * per second.
+ * Modify __DEBUG_TUNING__ to true to switch to calibration mode: the
+ * host sends reference loads, each is measured with the sweep engine,
+ * and a fit request writes the least squares gains and offsets to the
+ * calibration store. Modify __DEBUG_CSV__ to true to stream CSV lines
+ * instead of binary point frames. Modify __SUMMARY_ONLY__ to true to
+ * send one summary (Isc, Voc, MPP, fill factor) per sweep instead of
+ * every point; the points of the last few passes stay in SRAM either
+ * way, for the host to read back in bulk. Modify __TIMED_SWEEP__ to
+ * true to step the DAC from the acquisition interrupt with a fixed
+ * settle time, for repeatable point timing. Modify __CAN_RESULTS__ to
+ * false to stop mirroring points and summaries onto the CAN bus. Modify
+ * __DELTA_STREAM__ to true to send the points of each batch as one
+ * delta compressed block instead of a frame per point. Modify
+ * __STAGE_TIMING__ to true to send the cycle counts of each stage of
+ * the scan loop after every pass; the host can also request the last
+ * ones. Modify __LOW_POWER_IDLE__ to true to let the MCU enter Stop 2
+ * once the profile queue has been empty for IDLE_GRACE; a byte from the
+ * host, CAN traffic with __WAKE_ON_CAN__, or the SWEEP_INTERVAL alarm
+ * wakes it, and the wake is reported. Set OVERSAMPLING to the number of
+ * ADC conversions averaged in hardware per sample. Modify the
+ * controller sections to optimize resolution and breadth of the
+ * sampling scheme. Serial baud rate starts at 115200 bits per second
+ * and is renegotiated with the host. Sweeps start when the host sends a
+ * profile frame (see the README); up to PROFILE_DEPTH profiles queue
+ * and run back to back, and the compiled plans of the last PLAN_CACHE
+ * are kept, so a repeat starts without rebuilding its code table.
+ * Calibration is per board, loaded from the last flash page at boot;
+ * the host writes it with the calibration frames, and DEFAULT_CAL is
+ * used until it has. Set NUM_CHANNELS to sweep several tracer channels
+ * at once; each profile then runs on every channel, interleaved on the
+ * shared ADC scan, and every result frame carries its channel. Adaptive
+ * stepping, timed sweeps and calibration mode use channel 0 only. A
+ * stream frame logs the operating point at a fixed DAC code, or dithers
+ * around the maximum power point, at a chosen record rate instead of
+ * sweeping; see the README. Every reverse pass is compared with its
+ * forward pass at matching DAC codes and the hysteresis reported;
+ * modify __AUTO_SPEED__ to true to tune the settle time of each regime
+ * to the shortest that keeps it within HYSTERESIS_LIMIT, for profiles
+ * that do not set one. Points, pass starts and received CAN frames
+ * carry the device time in us; the host maps it to its own with the
+ * time sync exchange, over serial or CAN. Faults such as an acquisition
+ * stall are reported to the host, the acquisition is restarted and the
+ * profile run again, up to FAULT_RETRIES times; the watchdog resets the
+ * MCU if a busy thread stops checking in for TASK_DEADLINE. Without
+ * CAN, results go on serial only. A link test frame queues a benchmark
+ * of the output paths (CSV, binary, delta blocks and CAN) with
+ * synthetic points, reporting the throughput and encoder cycles of
+ * each.
  */
 
 #include "mbed.h"
+#include "Acquisition/AdcDma.hpp"
+#include "Acquisition/Dac.hpp"
+#include "Acquisition/Sequencer.hpp"
+#include "Acquisition/StreamSampler.hpp"
+#include "Analysis/CurveExtractor.hpp"
+#include "Analysis/HysteresisTracker.hpp"
+#include "Analysis/SpeedTuner.hpp"
+#include "Calibration/CalStore.hpp"
+#include "Calibration/Calibration.hpp"
+#include "Calibration/LinearFit.hpp"
+#include "Comms/CanLink.hpp"
+#include "Comms/SerialLink.hpp"
+#include "Diagnostics/DeviceClock.hpp"
+#include "Diagnostics/FaultMonitor.hpp"
+#include "Diagnostics/StageStats.hpp"
+#include "Pipeline/PointPipeline.hpp"
+#include "Pipeline/ResultStore.hpp"
+#include "Pipeline/SensorCorrelator.hpp"
+#include "Pipeline/SensorSnapshot.hpp"
+#include "Pipeline/SpscRing.hpp"
+#include "Power/IdleManager.hpp"
+#include "Protocol/DeltaFrame.hpp"
+#include "Protocol/Frame.hpp"
+#include "Sweep/AdaptiveStepper.hpp"
+#include "Sweep/ChannelSweep.hpp"
+#include "Sweep/DacTable.hpp"
+#include "Sweep/Mode.hpp"
+#include "Sweep/PlanCache.hpp"
+#include "Sweep/PointSampler.hpp"
+#include "Sweep/Profile.hpp"
+#include "Sweep/SettleDetector.hpp"
+#include "Sweep/SweepKernel.hpp"
 
 const bool __DEBUG_TUNING__ = false;
+const bool __DEBUG_CSV__ = false;
+const bool __SUMMARY_ONLY__ = false;
+const bool __ADAPTIVE_SETTLE__ = true;
+const bool __ADAPTIVE_STEP__ = false;
+const bool __TIMED_SWEEP__ = false;
+const bool __CAN_RESULTS__ = true;
+const bool __DELTA_STREAM__ = false;
+const bool __STAGE_TIMING__ = false;
+const bool __LOW_POWER_IDLE__ = false;
+const bool __WAKE_ON_CAN__ = false;
+const bool __AUTO_SPEED__ = false;
 
-// 19200 baud rate.
+#define BAUD_RATE               115200
+#define CAN_RATE                100000 // bits/s, the Blackbody bus rate.
 #define BLINKING_RATE           250ms
-#define SETTLING_TIME           15000 // us
-#define ITERATIONS              5
+#define SETTLING_TIME           15000 // us, upper bound when adaptive.
+#define SETTLE_TOLERANCE        2 // ADC codes, mean change between blocks.
+#define SETTLE_MATCHES          2 // Consecutive blocks within tolerance.
+#define NUM_CHANNELS            1 // Tracer channels, up to AdcDma::MAX_CHANNELS.
+#define SAMPLE_RATE             (50000 / NUM_CHANNELS) // Hz, voltage/current pairs per channel.
+#define SENSOR_WINDOW           100 // ms, furthest a Blackbody frame may be from its point.
+#define OVERSAMPLING            16 // ADC conversions per pair code, 1 to disable.
+#define PROFILE_DEPTH           16 // Profiles queued ahead of the sweep, a power of two.
+#define PLAN_CACHE              2 // Compiled sweep plans kept, 2 KB of SRAM each.
+#define READOUT_CHUNK           32 // Points per readout frame.
+#define IDLE_GRACE              50ms // Empty queue time before Stop 2.
+#define CAL_READINGS            8 // Per reference load, each of 2^MAX_BLOCK_SHIFT blocks.
+#define SWEEP_INTERVAL          0 // s, alarm repeating the last profile when idle; 0 for none.
+#define STREAM_SETTLE           1000 // us, skipped after each dither step.
+#define STREAM_SENSOR_AGE       1000 // ms, oldest Blackbody reading attached to a record.
+#define STREAM_LINK_SHARE       75 // %, of the link a stream may take.
+#define HYSTERESIS_LIMIT        655 // Q0.16 of Pmax, largest power gap between passes when tuning.
+#define SPEED_MIN               ((uint64_t)AdcDma::BLOCK_PAIRS * 1000000 / SAMPLE_RATE) // us, one block.
+#define SPEED_MAX               (4 * SETTLING_TIME) // us, slowest settle tried when tuning.
+#define WATCHDOG_TIMEOUT        8000 // ms, without a kick before the MCU resets.
+#define TASK_DEADLINE           4000 // ms, longest a busy thread may go without checking in.
+#define FAULT_RETRIES           3 // Attempts at a profile, or at restarting acquisition.
+#define FAULT_RESET_DELAY       1000ms // For the fault report to go out before a reset.
+#define LINK_TEST_STALL         100000 // us, without progress before a link test path is given up.
+#define LINK_TEST_LINE          96 // Bytes, longest CSV line of a link test.
+
+/** Adaptive stepping, in DAC codes. Sweep bounds are in each profile. */
+#define STEP_MIN                2
+#define STEP_MAX                64
+#define STEP_BUDGET             64 // Points per sweep.
+#define STEP_TOLERANCE          3 // Local power error, /256 of the peak.
+
+/** Frames let through the CAN acceptance filters: the Blackbody frames and time sync. */
+const uint16_t CAN_IDS[] = { ID_BLKBDY_TEMP, ID_BLKBDY_IRRAD_1, ID_BLKBDY_IRRAD_2, ID_BLKBDY_FAULT, ID_TIME_SYNC };
+
+/** Baud rates offered to the host, fastest first. */
+const uint32_t LINK_RATES[] = { 921600, 460800, 230400 };
+
+/** Sense pins of each tracer channel; channel 1 is driven from A4. */
+const PinName VOLTAGE_PINS[] = { A6, A1 };
+const PinName CURRENT_PINS[] = { A0, A2 };
+static_assert(NUM_CHANNELS >= 1 && NUM_CHANNELS <= AdcDma::MAX_CHANNELS, "Unsupported channel count.");
+static_assert(NUM_CHANNELS <= Frame::MAX_CHANNELS, "Frames cannot tell the channels apart.");
 
 DigitalOut ledHeartbeat(D1);
-AnalogIn sensorVoltage(A6);
-AnalogIn sensorCurrent(A0);
+AdcDma adc(VOLTAGE_PINS, CURRENT_PINS, NUM_CHANNELS);
+Sequencer sequencer(adc);
+SettleDetector settle((SETTLE_TOLERANCE * AdcDma::BLOCK_PAIRS) << (4 - AdcDma::codeShift(OVERSAMPLING)), SETTLE_MATCHES);
+PointSampler<AdcDma> sampler(adc, settle);
+AdaptiveStepper stepper(STEP_MIN, STEP_MAX, STEP_BUDGET, STEP_TOLERANCE);
+PlanCache<PLAN_CACHE> plans;
 AnalogOut dacControl(A3);
-CAN can(D10, D2);
-CANMessage msg;
+#if NUM_CHANNELS > 1
+AnalogOut dacControl1(A4);
+#endif
+CanLink canLink(D10, D2); // RD, TD.
+SensorCorrelator correlator(canLink, (uint64_t)SENSOR_WINDOW * SAMPLE_RATE / (1000 * AdcDma::BLOCK_PAIRS));
+StreamSampler streamer(adc);
+SensorSnapshot sensors((uint64_t)STREAM_SENSOR_AGE * SAMPLE_RATE / (1000 * AdcDma::BLOCK_PAIRS));
+SerialLink serialLink(USBTX, USBRX, BAUD_RATE);
+PointPipeline pipeline;
+ResultStore results;
+CalStore calStore;
+CurveExtractor extractors[NUM_CHANNELS];
+HysteresisTracker trackers[NUM_CHANNELS];
+IdleManager idle(USBRX, D10); // Serial RX, CAN RD.
+FaultMonitor faults(WATCHDOG_TIMEOUT, TASK_DEADLINE);
+bool canUp = false; // The CAN controller started; results stay on serial otherwise.
+
+/** Route printf through the link so both share the negotiated rate. */
+FileHandle *mbed::mbed_override_console(int fd) {
+    return serialLink.getStream();
+}
 
 /** Tickers. */
 LowPowerTicker tickHeartbeat;
 void heartbeat(void) {ledHeartbeat = !ledHeartbeat;}
 
-enum Mode {
-    CELL,
-    MODULE,
-    ARRAY
+/** Regime of the current profile; MODULE until the PC sends one. */
+enum Mode mode = MODULE;
+
+/** Profiles received from the PC, waiting for the sweep thread. */
+SpscRing<Profile, PROFILE_DEPTH> profileQueue;
+Semaphore profilesQueued(0, PROFILE_DEPTH);
+volatile uint16_t profileCount = 0; // Profiles accepted, in the RX ISR.
+volatile uint8_t profileStatus = PROFILE_OK; // Last rejection.
+volatile uint16_t profileRejectId = ID_PROFILE;
+volatile uint32_t profileRejects = 0;
+
+/** Settle time of each regime tuned from the hysteresis of its pass pairs. */
+static_assert(NUM_MODES == 3, "One tuner per regime.");
+SpeedTuner tuners[NUM_MODES] = {
+    SpeedTuner(SPEED_MIN, SPEED_MAX, SPEED_MIN),
+    SpeedTuner(SPEED_MIN, SPEED_MAX, SPEED_MIN),
+    SpeedTuner(SPEED_MIN, SPEED_MAX, SPEED_MIN)
+};
+
+/** Stream stop requests, from the RX ISR; a running stream ends at the next record. */
+volatile uint32_t streamStops = 0;
+
+/** Why a stream ended, as sent in its status frame. */
+enum StreamEnd {
+    STREAM_RUNNING,
+    STREAM_COMPLETE,
+    STREAM_STOPPED,
+    STREAM_STALLED
+};
+
+/** Output paths of a link test, as bits of its path mask and the nibble of its stats. */
+enum LinkPath {
+    LINK_CSV,
+    LINK_BINARY,
+    LINK_DELTA,
+    LINK_CAN,
+    NUM_LINK_PATHS
+};
+
+/** Readout requested by the PC, served from the main thread. */
+enum ReadoutStatus {
+    READOUT_OK,
+    READOUT_NOT_STORED,
+    READOUT_BAD_CRC
+};
+volatile uint32_t readoutRequests = 0;
+volatile uint16_t readoutSweep = ResultStore::ANY_SWEEP;
+volatile uint8_t readoutStatus = READOUT_OK;
+
+/**
+ * Stage timing. The sweep thread times the DAC, settle and sample stages
+ * and hands them over at the end of each pass; the transmit thread adds
+ * calibrate and emit and keeps the last pass for the host to request.
+ */
+StageStats sweepStats;
+StageStats transmitStats;
+SpscRing<StageStats, 4> passTimings;
+Mutex timingLock;
+StageStats lastTiming;
+uint16_t lastTimingSweep = 0;
+volatile uint32_t timingRequests = 0;
+
+/** Calibration record chunks staged from the RX ISR, committed from the main thread. */
+volatile uint32_t calCommits = 0;
+volatile uint32_t calRejects = 0;
+volatile uint8_t calStatus = CAL_OK; // Last rejection.
+volatile uint16_t calRejectId = ID_CAL_WRITE;
+volatile uint16_t calOffset = 0;
+/**
+ * Held by a stream for the calibration it started with, whose zero inputs
+ * the stream ISR works from; a commit that cannot take it is refused.
+ */
+Mutex calInUse;
+
+/** Reference loads queued by the RX ISR in calibration mode. */
+struct CalReference {
+    uint8_t mode;
+    uint16_t dacCode;
+    uint32_t voltMv;
+    uint32_t currMa;
+    uint16_t gateMv;            /* Frame::GATE_NOT_MEASURED if not known. */
 };
+SpscRing<CalReference, 8> calReferences;
+volatile uint32_t calFitRequests = 0;
+volatile uint16_t calFitRevision = 0;
+/** Readings so far, per regime and term. */
+LinearFit calFits[NUM_MODES][NUM_CAL_TERMS];
+
+/**
+ * Time sync requests, stamped with the device time on arrival in the
+ * serial and CAN RX ISRs and answered from the main thread.
+ */
+struct TimeSync {
+    uint16_t sequence;
+    uint64_t hostUs;            /* Sender's time, echoed. */
+    uint64_t receivedUs;        /* Device time. */
+};
+SpscRing<TimeSync, 4> serialSyncs;
+SpscRing<TimeSync, 4> canSyncs;
+
+/** Set by the RX ISR for the main thread, which otherwise sleeps. */
+#define HOST_REQUEST            0x1
+EventFlags hostEvents;
+
+/** Threads. */
+Thread threadProcessing;
+Thread threadTesting;
+
+/**
+ * Settle after a DAC update, then accumulate the raw codes of the next
+ * blocks; see PointSampler. Returns the settle time used, in us.
+ *
+ * @return false A block did not arrive.
+ */
+bool samplePoint(uint8_t blocks, uint32_t settleLimit, bool adaptive, Moments *moments, uint32_t *settled) {
+    uint32_t since = StageStats::now();
+    if (!sampler.settle(settleLimit, adaptive, settled)) return false;
+    sweepStats.add(STAGE_SETTLE, since);
+
+    since = StageStats::now();
+    if (!sampler.accumulate(blocks, moments)) return false;
+    sweepStats.add(STAGE_SAMPLE, since);
+    return true;
+}
+
+/** Board glue for the sweep kernels, set up per profile. */
+struct BoardIo {
+    static const uint16_t BLOCK_PAIRS = AdcDma::BLOCK_PAIRS;
+    static const uint8_t CODE_SHIFT = AdcDma::codeShift(OVERSAMPLING);
+    static const uint8_t MAX_CHANNELS = NUM_CHANNELS;
+
+    uint8_t shift;              /* log2 of the blocks per point. */
+    uint32_t settleUs;          /* Upper bound on the settle time. */
+    bool adaptive;              /* Sample once settled, before settleUs. */
+    uint16_t lastCode;          /* Last DAC code written, the context of a stall. */
+
+    uint8_t blockShift(void) { return shift; }
+    void setDac(uint16_t code) {
+        uint32_t since = StageStats::now();
+        dacWrite(code);
+        lastCode = code;
+        sweepStats.add(STAGE_DAC, since);
+    }
+    uint32_t sample(uint8_t blocks, Moments *moments) {
+        uint32_t settled = 0;
+        if (!samplePoint(blocks, settleUs, adaptive, moments, &settled)) faults.raise(FAULT_ADC_STALL, lastCode);
+        return settled;
+    }
+    uint32_t clock(void) { return adc.getBlockCount(); }
+    uint32_t micros(void) { return (uint32_t)DeviceClock::now(); }
+    void post(const Point &point) {
+        faults.checkIn(TASK_SWEEP);
+        pipeline.push(point);
+    }
+    bool aborted(void) { return faults.isPending(); }
+    void flush(void) {
+        /* Ahead of the last batch, so it is there when that is seen. */
+        passTimings.push(sweepStats);
+        sweepStats.reset();
+        pipeline.flush();
+    }
+
+    uint32_t sequence(const DacTable &table, bool forward, uint8_t blocks) {
+        uint32_t period = adc.getBlockPeriodUs();
+        uint32_t settleBlocks = (settleUs + period - 1) / period;
+        if (settleBlocks > 0xFF) settleBlocks = 0xFF;
+        if (!sequencer.start(table.data(), table.size(), forward, settleBlocks, blocks)) {
+            faults.raise(FAULT_ADC_RESTART, 0);
+            return 0;
+        }
+        return settleBlocks * period;
+    }
+    bool collect(RawPoint *point) {
+        if (sequencer.collect(point)) {
+            faults.checkIn(TASK_SWEEP);
+            return true;
+        }
+        if (sequencer.hasStalled()) faults.raise(FAULT_ADC_STALL, 0);
+        return false;
+    }
+
+    /* Every channel at once; see ChannelSweep. */
+    uint8_t channels(void) { return NUM_CHANNELS; }
+    void setDac(uint8_t channel, uint16_t code) {
+        uint32_t since = StageStats::now();
+        dacWrite(channel, code);
+        lastCode = code;
+        sweepStats.add(STAGE_DAC, since);
+    }
+    void dropBlocks(void) { adc.flush(); }
+    const uint16_t *waitBlock(void) {
+        const uint16_t *block = adc.waitBlock();
+        if (block == nullptr) {
+            faults.raise(FAULT_ADC_STALL, lastCode);
+        } else {
+            faults.checkIn(TASK_SWEEP);
+        }
+        return block;
+    }
+    uint8_t stride(void) { return adc.getStride(); }
+    uint32_t blockPeriodUs(void) { return adc.getBlockPeriodUs(); }
+    uint32_t settleLimit(void) { return settleUs; }
+};
+BoardIo boardIo = { 0, SETTLING_TIME, __ADAPTIVE_SETTLE__, 0 };
+
+/** Print a calibrated point as Gate (V), Voltage (V), Current (A), Power (W). */
+void printPoint(const CalPoint &cal) {
+    int32_t power = (int64_t) cal.voltage * cal.current / 1000; // mW
+    printf(
+        "%f,%f,%f,%f",
+        (float) cal.gate / 1000,
+        (float) cal.voltage / 1000,
+        (float) cal.current / 1000,
+        (float) power / 1000
+    );
+}
+
+/**
+ * Send one sweep point. The binary frame carries raw codes only, so the
+ * hot path does no float formatting; CSV is kept for debugging.
+ */
+void emitPoint(const Point &point) {
+    if (__DEBUG_CSV__) {
+        /* Calibrated lazily, only for the debug stream. */
+        printPoint(calibrate(calStore.table(point.mode), point.dacCode, point.volt, point.curr));
+        printf(",%lu,%u,%u,%u,%lu\n", point.settleUs, point.voltNoise, point.currNoise, point.channel, point.timeUs);
+    } else {
+        /* Encoded in place in the TX ring. */
+        uint8_t *frame = serialLink.reserve(Frame::POINT_SIZE);
+        if (frame == nullptr) return;
+        uint32_t settleTicks = point.settleUs / Frame::SETTLE_UNIT_US;
+        Frame::encodePoint(
+            frame,
+            point.mode,
+            point.sampleId,
+            point.dacCode,
+            point.volt,
+            point.curr,
+            settleTicks > 0xFF ? 0xFF : settleTicks,
+            point.voltNoise,
+            point.currNoise,
+            point.timeUs,
+            point.channel
+        );
+        serialLink.commit(Frame::POINT_SIZE);
+    }
+}
+
+/**
+ * Send the points of a batch as compressed blocks, one per channel: the
+ * first point in full, then the code deltas. Settle time and noise are
+ * left to the readout.
+ */
+static_assert(Frame::deltaMaxSize(PointBatch::SIZE) <= 0xFF, "Block length must fit its byte.");
+void emitPointBlock(const PointBatch &batch) {
+    for (uint8_t c = 0; c < NUM_CHANNELS; ++c) {
+        uint16_t first = 0;
+        uint16_t count = 0;
+        for (uint16_t k = 0; k < batch.count; ++k) {
+            if (batch.points[k].channel != c) continue;
+            if (count++ == 0) first = k;
+        }
+        if (count == 0) continue;
+        uint8_t *frame = serialLink.reserve(Frame::deltaMaxSize(count));
+        if (frame == nullptr) return;
+
+        /* A channel's points are in step order, so their IDs count up. */
+        Frame::DeltaEncoder encoder;
+        encoder.begin(frame, batch.points[first].mode, batch.points[first].sampleId, c);
+        for (uint16_t k = first; k < batch.count; ++k) {
+            const Point &point = batch.points[k];
+            if (point.channel == c) encoder.add(point.dacCode, point.volt, point.curr, point.timeUs);
+        }
+        serialLink.commit(encoder.seal());
+    }
+}
+
+/** Queue one sweep point on the CAN bus; never blocks. */
+void emitCanPoint(const Point &point) {
+    uint8_t data[Frame::CAN_SIZE];
+    Frame::encodeCanPoint(data, point.mode, point.sampleId, point.dacCode, point.volt, point.curr, point.channel);
+    canLink.post(ID_POINT, data, Frame::CAN_SIZE);
+}
+
+/** Queue the figures of merit of a sweep pass on the CAN bus. */
+void emitCanSummary(uint8_t channel, uint16_t sweepId, const CurveSummary &summary) {
+    uint8_t data[Frame::CAN_SIZE];
+    uint8_t mpp[Frame::CAN_SIZE];
+    Frame::encodeCanSummary(
+        data,
+        mpp,
+        sweepId,
+        summary.isc,
+        summary.voc,
+        summary.imp,
+        summary.vmp,
+        summary.pmax,
+        summary.fillFactor,
+        channel
+    );
+    canLink.post(ID_SUMMARY, data, Frame::CAN_SIZE);
+    canLink.post(ID_SUMMARY_MPP, mpp, Frame::CAN_SIZE);
+}
+
+/** Forward a Blackbody frame, tagged with its nearest sweep point. */
+void emitSensor(const CanFrame &frame, uint16_t sampleId) {
+    if (__DEBUG_CSV__) {
+        printf("Sensor 0x%03x @ %u, %lu us:", frame.msg.id, sampleId, (uint32_t)frame.timeUs);
+        for (uint8_t k = 0; k < frame.msg.len; ++k) printf(" %02x", frame.msg.data[k]);
+        printf("\n");
+    } else {
+        uint8_t *out = serialLink.reserve(Frame::SENSOR_SIZE);
+        if (out == nullptr) return;
+        Frame::encodeSensor(out, frame.msg.id, sampleId, frame.msg.data, frame.msg.len, (uint32_t)frame.timeUs);
+        serialLink.commit(Frame::SENSOR_SIZE);
+    }
+}
+
+/** Announce a sweep pass and the device time it started at. */
+void emitSweepStart(uint8_t mode, uint16_t sweepId, bool reverse, uint64_t startUs) {
+    if (__DEBUG_CSV__) {
+        printf("Pass %u %s @ %lu us\n", sweepId, reverse ? "reverse" : "forward", (uint32_t)startUs);
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::SWEEP_START_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeSweepStart(frame, mode, sweepId, reverse, startUs);
+        serialLink.commit(Frame::SWEEP_START_SIZE);
+    }
+}
+
+/** Send the figures of merit of one channel of a finished sweep pass. */
+void emitSummary(uint8_t mode, uint8_t channel, uint16_t sweepId, const CurveSummary &summary) {
+    if (__DEBUG_CSV__) {
+        printf(
+            "Channel %u Isc (A),Voc (V),Imp (A),Vmp (V),Pmax (W),FF: %f,%f,%f,%f,%f,%f\n",
+            channel,
+            (float) summary.isc / 1000,
+            (float) summary.voc / 1000,
+            (float) summary.imp / 1000,
+            (float) summary.vmp / 1000,
+            (float) summary.pmax / 1000,
+            (float) summary.fillFactor / 65536
+        );
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::SUMMARY_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeSummary(
+            frame,
+            mode,
+            sweepId,
+            summary.isc,
+            summary.voc,
+            summary.imp,
+            summary.vmp,
+            summary.pmax,
+            summary.fillFactor,
+            channel
+        );
+        serialLink.commit(Frame::SUMMARY_SIZE);
+    }
+}
+
+/** Tell the PC a profile has run all its passes. */
+void emitFinish(uint8_t mode, uint16_t profileId, uint8_t passes) {
+    if (__DEBUG_CSV__) {
+        printf("Profile %u finished: %u passes\n", profileId, passes);
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::FINISH_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeFinish(frame, mode, profileId, passes);
+        serialLink.commit(Frame::FINISH_SIZE);
+    }
+}
+
+/** Send the stage timing of a pass. */
+void emitTiming(uint16_t sweepId, const StageStats &stats) {
+    uint32_t cycles[3 * Frame::TIMING_STAGES];
+    for (uint8_t s = 0; s < NUM_STAGES; ++s) {
+        stats.summarize((enum Stage)s, &cycles[3 * s], &cycles[3 * s + 1], &cycles[3 * s + 2]);
+    }
+    uint16_t points = stats.get(STAGE_DAC).count;
+
+    if (__DEBUG_CSV__) {
+        static const char *const NAMES[NUM_STAGES] = { "DAC", "Settle", "Sample", "Calibrate", "Emit" };
+        printf("Timing of sweep %u, %u points (cycles min/mean/max):", sweepId, points);
+        for (uint8_t s = 0; s < NUM_STAGES; ++s) {
+            printf(" %s %lu/%lu/%lu", NAMES[s], cycles[3 * s], cycles[3 * s + 1], cycles[3 * s + 2]);
+        }
+        printf("\n");
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::TIMING_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeTiming(frame, sweepId, points, cycles);
+        serialLink.commit(Frame::TIMING_SIZE);
+    }
+}
+static_assert(NUM_STAGES == Frame::TIMING_STAGES, "Timing record must cover every stage.");
+
+/** End of a pass in the transmit thread: combine and keep its timing. */
+void finishTiming(uint16_t sweepId) {
+    StageStats stats;
+    passTimings.pop(&stats);
+    stats.merge(transmitStats);
+    transmitStats.reset();
+
+    timingLock.lock();
+    lastTiming = stats;
+    lastTimingSweep = sweepId;
+    timingLock.unlock();
+    if (__STAGE_TIMING__) emitTiming(sweepId, stats);
+}
+
+/** Send the forward/reverse difference of one channel of a pass pair. */
+void emitHysteresis(
+    uint8_t mode,
+    uint8_t channel,
+    uint16_t forwardId,
+    uint16_t reverseId,
+    const HysteresisReport &report,
+    uint32_t settleUs,
+    uint32_t nextUs
+) {
+    if (__DEBUG_CSV__) {
+        printf(
+            "Channel %u sweeps %u/%u hysteresis: %u points, max dI %ld mA @ %u, mean dI %ld mA, max dP %ld mW (%f of Pmax), settle %lu us, next %lu us\n",
+            channel,
+            forwardId,
+            reverseId,
+            report.matched,
+            report.maxCurrDiff,
+            report.maxDacCode,
+            report.meanCurrDiff,
+            report.maxPowerDiff,
+            (float) report.ratio / 65536,
+            settleUs,
+            nextUs
+        );
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::HYSTERESIS_SIZE);
+        if (frame == nullptr) return;
+        uint32_t settle = settleUs / Frame::SETTLE_UNIT_US;
+        uint32_t next = nextUs / Frame::SETTLE_UNIT_US;
+        Frame::encodeHysteresis(
+            frame,
+            mode,
+            forwardId,
+            reverseId,
+            report.matched,
+            report.maxCurrDiff,
+            report.maxDacCode,
+            report.meanCurrDiff,
+            report.maxPowerDiff,
+            report.ratio,
+            settle > 0xFFFF ? 0xFFFF : settle,
+            next > 0xFFFF ? 0xFFFF : next,
+            channel
+        );
+        serialLink.commit(Frame::HYSTERESIS_SIZE);
+    }
+}
+
+/**
+ * End of a reverse pass in the transmit thread: report the hysteresis of
+ * each channel against its forward pass and, when tuning, hand the worst
+ * of them to the regime's tuner.
+ */
+void finishHysteresis(uint8_t mode, uint16_t forwardId, uint16_t reverseId, uint32_t settleUs) {
+    HysteresisReport reports[NUM_CHANNELS];
+    bool reported[NUM_CHANNELS];
+    bool any = false;
+    uint16_t worst = 0;
+    for (uint8_t c = 0; c < NUM_CHANNELS; ++c) {
+        reported[c] = trackers[c].finish(&reports[c]);
+        if (!reported[c]) continue;
+        any = true;
+        if (reports[c].ratio > worst) worst = reports[c].ratio;
+    }
+    if (!any) return;
+
+    uint32_t nextUs = 0;
+    if (__AUTO_SPEED__ && mode < NUM_MODES) {
+        tuners[mode].update(settleUs, worst <= HYSTERESIS_LIMIT);
+        nextUs = tuners[mode].get();
+    }
+    for (uint8_t c = 0; c < NUM_CHANNELS; ++c) {
+        if (reported[c]) emitHysteresis(mode, c, forwardId, reverseId, reports[c], settleUs, nextUs);
+    }
+}
+
+/**
+ * Transmit thread: drain point batches while the sweep fills the next,
+ * extract the figures of merit of each pass as its points go by and
+ * slot in the Blackbody frames received around them.
+ */
+void transmitResults(void) {
+    uint16_t sweepId = 0;
+    uint8_t sweepMode = mode;
+    uint8_t passes = 0;
+    bool storing = false;
+    bool reverse = false;
+    bool paired = false;        /* A forward pass waits for its reverse. */
+    uint16_t forwardId = 0;
+    uint32_t pairSettle = 0;    /* Longest settle time of the pair, us. */
+    while (1) {
+        PointBatch *batch = pipeline.wait();
+        faults.busy(TASK_TRANSMIT);
+        if (!storing && batch->count > 0) {
+            results.begin(sweepId, batch->points[0].mode);
+            storing = true;
+            reverse = batch->points[0].reverse;
+            if (!reverse) pairSettle = 0;
+            for (uint8_t c = 0; c < NUM_CHANNELS; ++c) trackers[c].begin(reverse);
+            emitSweepStart(batch->points[0].mode, sweepId, reverse, batch->startUs);
+        }
+        for (uint16_t k = 0; k < batch->count; ++k) {
+            const Point &point = batch->points[k];
+            results.append(point);
+            uint32_t since = StageStats::now();
+            const CalTable &table = calStore.table(point.mode);
+            CalPoint cal = calibrate(table, point.dacCode, point.volt, point.curr);
+            extractors[point.channel].update(cal);
+            trackers[point.channel].update(point, cal, table);
+            transmitStats.add(STAGE_CALIBRATE, since);
+            if (point.settleUs > pairSettle) pairSettle = point.settleUs;
+            sweepMode = point.mode;
+            correlator.update(point, emitSensor);
+            if (!__SUMMARY_ONLY__) {
+                since = StageStats::now();
+                if (!__DELTA_STREAM__ || __DEBUG_CSV__) emitPoint(point);
+                if (__CAN_RESULTS__ && canUp) emitCanPoint(point);
+                transmitStats.add(STAGE_EMIT, since);
+            }
+        }
+        if (!__SUMMARY_ONLY__ && __DELTA_STREAM__ && !__DEBUG_CSV__) {
+            uint32_t since = StageStats::now();
+            emitPointBlock(*batch);
+            transmitStats.add(STAGE_EMIT, since);
+        }
+        if (batch->last) {
+            results.end();
+            storing = false;
+            correlator.finish(emitSensor);
+            for (uint8_t c = 0; c < NUM_CHANNELS; ++c) {
+                CurveSummary summary = extractors[c].finish();
+                emitSummary(sweepMode, c, sweepId, summary);
+                if (__CAN_RESULTS__ && canUp) emitCanSummary(c, sweepId, summary);
+                extractors[c].reset();
+            }
+            if (!reverse) {
+                forwardId = sweepId;
+                paired = true;
+            } else if (paired) {
+                finishHysteresis(sweepMode, forwardId, sweepId, pairSettle);
+                paired = false;
+            }
+            finishTiming(sweepId);
+            ++sweepId;
+            if (passes < 0xFF) ++passes;
+        }
+        if (batch->done) {
+            emitFinish(sweepMode, batch->profileId, passes);
+            passes = 0;
+            paired = false;
+        }
+        pipeline.release(batch);
+        faults.idle(TASK_TRANSMIT);
+    }
+}
+
+/**
+ * Calibration frames, from the RX ISR: chunks of a record are staged,
+ * references queued and commits and fits left to the main thread.
+ */
+void onCalFrame(const uint8_t *frame, uint16_t msgId) {
+    uint16_t context = 0;
+    enum CalStatus status = CAL_OK;
+    switch (msgId) {
+        case ID_CAL_WRITE: {
+            const uint8_t *data;
+            if (Frame::decodeCalWrite(frame, &context, &data)) {
+                status = calStore.stage(context, data, Frame::CAL_CHUNK);
+            } else {
+                status = CAL_BAD_CRC;
+            }
+            break;
+        }
+        case ID_CAL_COMMIT:
+            if (crc8(frame, Frame::CAL_COMMIT_SIZE - 1) == frame[Frame::CAL_COMMIT_SIZE - 1]) {
+                calCommits = calCommits + 1;
+            } else {
+                status = CAL_BAD_CRC;
+            }
+            break;
+        case ID_CAL_REFERENCE: {
+            CalReference reference;
+            if (!Frame::decodeCalReference(
+                frame,
+                &reference.mode,
+                &reference.dacCode,
+                &reference.voltMv,
+                &reference.currMa,
+                &reference.gateMv
+            )) {
+                status = CAL_BAD_CRC;
+            } else if (reference.mode >= NUM_MODES) {
+                status = CAL_BAD_REGIME;
+            } else if (!calReferences.push(reference)) {
+                status = CAL_QUEUE_FULL;
+            }
+            context = reference.dacCode;
+            break;
+        }
+        case ID_CAL_FIT: {
+            uint16_t revision;
+            if (Frame::decodeCalFit(frame, &revision)) {
+                calFitRevision = revision;
+                calFitRequests = calFitRequests + 1;
+            } else {
+                status = CAL_BAD_CRC;
+            }
+            break;
+        }
+        default:
+            return;
+    }
+    if (status != CAL_OK) {
+        calStatus = status;
+        calRejectId = msgId;
+        calOffset = context;
+        calRejects = calRejects + 1;
+    }
+    if (status != CAL_OK || msgId != ID_CAL_WRITE) hostEvents.set(HOST_REQUEST);
+}
+
+/** Fastest stream the link carries in its STREAM_LINK_SHARE, records/s. */
+uint16_t streamRateLimit(void) {
+    uint32_t rate = serialLink.getBaud() / 10 * STREAM_LINK_SHARE / 100 / Frame::STREAM_DATA_SIZE;
+    if (rate > SAMPLE_RATE) rate = SAMPLE_RATE;
+    return rate > 0xFFFF ? 0xFFFF : (uint16_t)rate;
+}
+
+/**
+ * Serial RX ISR: validate each profile frame and queue it for the sweep
+ * thread. Rejections are reported from the main thread.
+ */
+void onFrame(const uint8_t *frame, uint16_t msgId) {
+    if (msgId == ID_TIME_SYNC) {
+        TimeSync sync;
+        sync.receivedUs = DeviceClock::now();
+        if (Frame::decodeTimeSync(frame, &sync.sequence, &sync.hostUs) && serialSyncs.push(sync)) {
+            hostEvents.set(HOST_REQUEST);
+        }
+        return;
+    }
+    if (msgId == ID_TIMING_REQUEST) {
+        if (crc8(frame, Frame::TIMING_REQUEST_SIZE - 1) == frame[Frame::TIMING_REQUEST_SIZE - 1]) {
+            timingRequests = timingRequests + 1;
+            hostEvents.set(HOST_REQUEST);
+        }
+        return;
+    }
+    if (msgId >= ID_CAL_WRITE && msgId <= ID_CAL_FIT) {
+        onCalFrame(frame, msgId);
+        return;
+    }
+    if (msgId == ID_READOUT) {
+        uint16_t sweepId = ResultStore::ANY_SWEEP;
+        readoutStatus = Frame::decodeReadout(frame, &sweepId) ? READOUT_OK : READOUT_BAD_CRC;
+        readoutSweep = sweepId;
+        readoutRequests = readoutRequests + 1;
+        hostEvents.set(HOST_REQUEST);
+        return;
+    }
+
+    uint8_t regime;
+    uint16_t startMv, endMv, resolutionMv;
+    uint8_t blockShift = 0;
+    uint8_t settle = 0;
+    uint8_t repeats = 1;
+    enum ProfileStatus status = PROFILE_OK;
+    Profile profile;
+
+    if (msgId == ID_PROFILE) {
+        Frame::decodeProfile(frame, &regime, &startMv, &endMv, &resolutionMv);
+    } else if (msgId == ID_PROFILE_BATCH) {
+        if (!Frame::decodeBatch(
+            frame, &regime, &startMv, &endMv, &resolutionMv, &blockShift, &settle, &repeats
+        )) {
+            status = PROFILE_BAD_CRC;
+        }
+    } else if (msgId == ID_STREAM) {
+        uint8_t ditherMv;
+        uint16_t rateHz, durationS;
+        if (!Frame::decodeStream(frame, &regime, &startMv, &ditherMv, &rateHz, &durationS)) {
+            status = PROFILE_BAD_CRC;
+        } else if (rateHz == 0) {
+            streamStops = streamStops + 1;
+            return;
+        } else {
+            status = makeStream(regime, startMv, ditherMv, rateHz, durationS, streamRateLimit(), &profile);
+        }
+    } else if (msgId == ID_LINK_TEST) {
+        uint16_t records;
+        uint8_t paths;
+        if (!Frame::decodeLinkTest(frame, &records, &paths)) {
+            status = PROFILE_BAD_CRC;
+        } else {
+            status = makeLinkTest(records, paths, (1 << NUM_LINK_PATHS) - 1, &profile);
+        }
+    } else {
+        return;
+    }
+
+    if (msgId == ID_PROFILE || msgId == ID_PROFILE_BATCH) {
+        if (status == PROFILE_OK) status = makeProfile(regime, startMv, endMv, resolutionMv, &profile);
+        if (status == PROFILE_OK) status = setBatch(blockShift, settle, repeats, &profile);
+    }
+    if (status == PROFILE_OK) {
+        profile.id = profileCount;
+        if (profileQueue.push(profile)) {
+            profileCount = profileCount + 1;
+            profilesQueued.release();
+            return;
+        }
+        status = PROFILE_QUEUE_FULL;
+    }
+    profileStatus = status;
+    profileRejectId = msgId == ID_PROFILE_BATCH ? ID_PROFILE : msgId;
+    profileRejects = profileRejects + 1;
+    hostEvents.set(HOST_REQUEST);
+}
+
+/** Time sync frames from the CAN bus, stamped in the RX ISR. */
+void onCanSync(const CanFrame &frame) {
+    TimeSync sync;
+    sync.receivedUs = frame.timeUs;
+    if (Frame::decodeCanTimeSync(frame.msg.data, frame.msg.len, &sync.sequence, &sync.hostUs) && canSyncs.push(sync)) {
+        hostEvents.set(HOST_REQUEST);
+    }
+}
+
+/** Answer a time sync request to the PC; source is Frame::SYNC_SERIAL or SYNC_CAN. */
+void emitTimeSync(uint8_t source, const TimeSync &sync) {
+    if (__DEBUG_CSV__) {
+        printf(
+            "Time sync %u from %s: sent %lu, received %lu us, replied %lu us\n",
+            sync.sequence,
+            source == Frame::SYNC_CAN ? "CAN" : "serial",
+            (uint32_t)sync.hostUs,
+            (uint32_t)sync.receivedUs,
+            (uint32_t)DeviceClock::now()
+        );
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::TIME_SYNC_REPLY_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeTimeSyncReply(frame, source, sync.sequence, sync.hostUs, sync.receivedUs, DeviceClock::now());
+        serialLink.commit(Frame::TIME_SYNC_REPLY_SIZE);
+    }
+}
+
+/** Tell the PC a request was refused. */
+void emitException(uint16_t msgId, uint8_t status, uint16_t context) {
+    if (__DEBUG_CSV__) {
+        printf("Request 0x%03x refused: %u\n", msgId, status);
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::EXCEPTION_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeException(frame, msgId, status, context);
+        serialLink.commit(Frame::EXCEPTION_SIZE);
+    }
+}
+
+/** Report a fault that cannot be recovered from here, then reset the MCU. */
+MBED_NORETURN void resetOnFault(enum FaultCode code, uint16_t context) {
+    emitException(ID_FAULT, code, context);
+    serialLink.drain();
+    ThisThread::sleep_for(FAULT_RESET_DELAY);
+    system_reset();
+}
+
+/**
+ * Send a stored pass back in readout frames of READOUT_CHUNK points.
+ * The pass is pinned meanwhile, so sweeping carries on and at worst cuts
+ * a new pass short.
+ */
+void emitReadout(uint16_t sweepId) {
+    SweepRecord record;
+    if (!results.pin(sweepId, &record)) {
+        emitException(ID_READOUT, READOUT_NOT_STORED, sweepId);
+        return;
+    }
+
+    for (uint16_t first = 0; first < record.count; first += READOUT_CHUNK) {
+        uint8_t count = record.count - first < READOUT_CHUNK ? record.count - first : READOUT_CHUNK;
+        if (__DEBUG_CSV__) {
+            for (uint8_t k = 0; k < count; ++k) {
+                const PackedPoint &point = results.at(record, first + k);
+                printf(
+                    "Readout %u,%u,%u,%u,%u,%u,%u,%u\n",
+                    record.sweepId,
+                    first + k,
+                    point.dacCode >> 12,
+                    point.dacCode & 0xFFF,
+                    point.volt,
+                    point.curr,
+                    point.settle,
+                    point.noise
+                );
+            }
+            continue;
+        }
+
+        /* Encoded in place; other frames may go out between chunks. */
+        uint8_t *frame = serialLink.reserve(Frame::readoutSize(count));
+        if (frame == nullptr) break;
+        uint8_t *out = frame + Frame::encodeReadoutHeader(
+            frame, record.mode, record.sweepId, record.count, first, count
+        );
+        for (uint8_t k = 0; k < count; ++k) {
+            const PackedPoint &point = results.at(record, first + k);
+            out += Frame::encodePacked(out, point.dacCode, point.volt, point.curr, point.settle, point.noise);
+        }
+        serialLink.commit(Frame::sealReadout(frame, count));
+    }
+    results.unpin();
+}
 
-float calibrateDACOut(float in) {
-    // const float slope = 9.9539;
-    // const float intercept = 0.0583;
-    return in;// * slope + intercept;
+/**
+ * One sweep pass with the kernel specialized for regime M. Both
+ * directions of a profile share the code table.
+ */
+template <enum Mode M>
+void runSweep(const DacTable &table, bool forward) {
+    pipeline.begin(DeviceClock::now());
+    if (__ADAPTIVE_STEP__) {
+        SweepKernel<M, BoardIo>::sweepAdaptive(boardIo, stepper, table, forward);
+    } else if (__TIMED_SWEEP__) {
+        SweepKernel<M, BoardIo>::sweepTimed(boardIo, table, forward);
+    } else if (NUM_CHANNELS > 1) {
+        ChannelSweep<M, BoardIo>::sweep(boardIo, table, forward, settle, boardIo.adaptive);
+    } else {
+        SweepKernel<M, BoardIo>::sweep(boardIo, table, forward);
+    }
 }
 
-float calibrateVoltageSensor(float in, float current, int numIterations, enum Mode mode) {
-    // + calibration offset for internal PCB resistances causing a voltage drop prior to the voltage sensor. 
+/** Measure one point at a DAC code, outside of a sweep. */
+Point measureAt(uint16_t code) {
     switch (mode) {
         case CELL:
-            return 1.1047 * in / numIterations;
-        case MODULE:
-            return 5.4591 * in / numIterations;
+            return SweepKernel<CELL, BoardIo>::measure(boardIo, code, 0);
         case ARRAY:
-            return 111.8247 * in / numIterations;
+            return SweepKernel<ARRAY, BoardIo>::measure(boardIo, code, 0);
+        case MODULE:
         default:
-            tickHeartbeat.detach();
-            ledHeartbeat = 1;
-            while (1) {}
+            return SweepKernel<MODULE, BoardIo>::measure(boardIo, code, 0);
     }
 }
 
-float calibrateCurrentSensor(float in, int numIterations) {
-    return 8.1169 * in / numIterations;
+/** Tell the PC which calibration is in use. */
+void emitCalStatus(void) {
+    if (__DEBUG_CSV__) {
+        printf(
+            "Calibration %s, revision %u, CRC %08lx\n",
+            calStore.isLoaded() ? "stored" : "built in",
+            calStore.getRevision(),
+            calStore.getCrc()
+        );
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::CAL_STATUS_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeCalStatus(frame, calStore.isLoaded(), calStore.getRevision(), calStore.getCrc());
+        serialLink.commit(Frame::CAL_STATUS_SIZE);
+    }
 }
 
-int main() {
+/** Tell the PC what woke the MCU and how long acquisition took to restart. */
+void emitWake(enum WakeSource source, uint32_t sleptMs, uint32_t latencyUs) {
+    if (__DEBUG_CSV__) {
+        printf("Wake %u after %lu ms, first block in %lu us\n", source, sleptMs, latencyUs);
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::WAKE_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeWake(frame, source, sleptMs, latencyUs);
+        serialLink.commit(Frame::WAKE_SIZE);
+    }
+}
+
+/**
+ * Quiesce the board and sleep until a wake event. Everything already
+ * swept goes out first. Peripheral registers, the DAC output among them,
+ * are retained in Stop 2, so only the deep sleep locks are let go: the
+ * ADC trigger and the serial RX interrupt.
+ */
+enum WakeSource idleUntilWake(uint32_t alarmS) {
+    pipeline.drain();
+    serialLink.drain();
+    for (uint8_t k = 0; canUp && k < 20 && !canLink.isIdle(); ++k) ThisThread::sleep_for(1ms);
+
+    adc.pause();
+    tickHeartbeat.detach();
+    ledHeartbeat = 0;
+    serialLink.suspend();
+    uint64_t since = DeviceClock::now();
+    enum WakeSource source = idle.sleep(alarmS, __WAKE_ON_CAN__);
+    DeviceClock::catchUp(since, idle.getSleptUs());
     tickHeartbeat.attach(&heartbeat, 500ms);
-    dacControl = 0.0; // 1.0 for open circuit, 0.0 for short circuit
-    enum Mode mode = MODULE;
+    return source;
+}
 
-    if (__DEBUG_TUNING__) {
-        printf("DEBUG MODE\n");
-        ThisThread::sleep_for(5000ms);
-
-        while(1) {
-            ThisThread::sleep_for(1000ms);
-            float sVolt = 0.0;
-            float sCurr = 0.0;
-
-            for (uint8_t j = 0; j < ITERATIONS; ++j) {
-                wait_us(SETTLING_TIME);
-                sVolt += sensorVoltage.read();
-                sCurr += sensorCurrent.read();
-            }
+/**
+ * Restart the acquisition clock and wait for its first block, a few times
+ * over; if it never comes back, the MCU is reset.
+ */
+void restartAcquisition(void) {
+    for (uint8_t attempt = 0; attempt < FAULT_RETRIES; ++attempt) {
+        adc.pause();
+        if (adc.resume() && adc.waitBlock() != nullptr) return;
+    }
+    resetOnFault(FAULT_ADC_RESTART, 0);
+}
+
+/**
+ * Report the pending fault and get the sweep engine back to where a
+ * profile can start: the sequencer and stream stopped, and acquisition
+ * running with a fresh block.
+ */
+void recoverFromFault(void) {
+    enum FaultCode code;
+    uint16_t context;
+    if (faults.take(&code, &context)) emitException(ID_FAULT, code, context);
+    sequencer.abort();
+    streamer.stop();
+    restartAcquisition();
+}
+
+/** Restart acquisition after a wake; returns the us from the wake interrupt to the first block. */
+uint32_t resumeAcquisition(void) {
+    restartAcquisition();
+    return (StageStats::now() - idle.getWakeCycles()) / (SystemCoreClock / 1000000);
+}
+
+/**
+ * Wait for the next profile. With __LOW_POWER_IDLE__, the MCU sleeps
+ * once the queue has been empty for IDLE_GRACE; the SWEEP_INTERVAL alarm
+ * repeats the last profile, if there is one.
+ *
+ * @return false Nothing to run yet.
+ */
+bool nextProfile(Profile *profile, bool repeatable) {
+    if (!__LOW_POWER_IDLE__) {
+        profilesQueued.acquire();
+        return profileQueue.pop(profile);
+    }
+    if (profilesQueued.try_acquire_for(IDLE_GRACE)) return profileQueue.pop(profile);
+
+    enum WakeSource source = idleUntilWake(repeatable ? SWEEP_INTERVAL : 0);
+    uint32_t latencyUs = resumeAcquisition();
+    if (source == WAKE_NONE) {
+        /* Wait awake instead, rather than retry every IDLE_GRACE. */
+        emitException(ID_FAULT, FAULT_SLEEP, 0);
+        profilesQueued.acquire();
+        return profileQueue.pop(profile);
+    }
+    emitWake(source, idle.getSleptMs(), latencyUs);
+    return source == WAKE_ALARM;
+}
 
-            float dacVolt = calibrateDACOut(dacControl);
-            sCurr = calibrateCurrentSensor(sCurr, ITERATIONS);
-            sVolt = calibrateVoltageSensor(sVolt, sCurr, ITERATIONS, mode);
-            printf(
-                // "%f,%f,%f,%f\n", 
-                "Open Circuit\nGate (V): %f, VSense (V): %f, ISense (A): %f, V*I (W): %f\n", 
-                dacVolt, 
-                sVolt,
-                sCurr,
-                sVolt * sCurr
+/**
+ * Send one stream record, calibrated, with the Blackbody readings
+ * nearest to it. The power adds the covariance of the samples to the
+ * product of the means, so that ripple on the panel is not lost.
+ *
+ * @return false The link had no room for it.
+ */
+bool emitStreamRecord(uint8_t mode, const StreamRecord &record, uint16_t voltZero, uint16_t currZero) {
+    const uint8_t shift = AdcDma::codeShift(OVERSAMPLING);
+    const CalTable &table = calStore.table(mode);
+    uint16_t volt = (uint16_t)(((uint64_t)record.voltSum << shift) / record.pairs);
+    uint16_t curr = (uint16_t)(((uint64_t)record.currSum << shift) / record.pairs);
+    CalPoint cal = calibrate(table, record.dacCode, volt, curr);
+
+    double meanV = (double)record.voltSum / record.pairs - voltZero;
+    double meanI = (double)record.currSum / record.pairs - currZero;
+    double covariance = (double)record.powerSum / record.pairs - meanV * meanI;
+    double scale = (double)(1 << (2 * shift)) * table.voltage.gain * table.current.gain / 4294967296.0;
+    int32_t power = (int32_t)((int64_t)cal.voltage * cal.current / 1000 + (int64_t)(covariance * scale / 1000.0));
+
+    int16_t temperature = sensors.getTemperature(record.tick);
+    uint16_t irradiance1 = sensors.getIrradiance(1, record.tick);
+    uint16_t irradiance2 = sensors.getIrradiance(2, record.tick);
+
+    if (__DEBUG_CSV__) {
+        printf(
+            "Stream %u,%u,%f,%f,%f,%d,%u,%u,%lu\n",
+            record.index,
+            record.dacCode,
+            (float) cal.voltage / 1000,
+            (float) cal.current / 1000,
+            (float) power / 1000,
+            temperature,
+            irradiance1,
+            irradiance2,
+            record.timeUs
+        );
+        return true;
+    }
+    uint8_t *frame = serialLink.reserve(Frame::STREAM_DATA_SIZE);
+    if (frame == nullptr) return false;
+    Frame::encodeStreamData(
+        frame,
+        mode,
+        record.index,
+        record.dacCode,
+        cal.voltage,
+        cal.current,
+        power,
+        temperature,
+        irradiance1,
+        irradiance2,
+        record.timeUs
+    );
+    serialLink.commit(Frame::STREAM_DATA_SIZE);
+    return true;
+}
+
+/** Send the counters of a stream, and why it ended if it has. */
+void emitStreamStatus(uint8_t mode, uint32_t unsent, enum StreamEnd reason) {
+    if (__DEBUG_CSV__) {
+        printf(
+            "Stream status: %lu records, %lu dropped, %lu unsent, end %u\n",
+            streamer.getRecords(),
+            streamer.getDropped(),
+            unsent,
+            reason
+        );
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::STREAM_STATUS_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeStreamStatus(frame, mode, streamer.getRecords(), streamer.getDropped(), unsent, reason);
+        serialLink.commit(Frame::STREAM_STATUS_SIZE);
+    }
+}
+
+/**
+ * Log the operating point of a stream profile until it has run its
+ * length or the host stops it, with a status frame every second. The ISR
+ * samples and dithers on its own; this thread only calibrates and sends,
+ * and if it falls behind, the ISR drops and counts records rather than
+ * wait for it.
+ *
+ * @return false The records stopped coming; a fault is raised.
+ */
+bool runStream(const Profile &profile) {
+    /* The transmit thread is idle once drained, so the CAN frames are ours meanwhile. */
+    pipeline.drain();
+    sensors.reset();
+
+    calInUse.lock();
+    const uint8_t shift = AdcDma::codeShift(OVERSAMPLING);
+    const CalTable &table = calStore.table(profile.mode);
+    uint16_t voltZero = zeroInput(table.voltage, SENSOR_FULL_SCALE) >> shift;
+    uint16_t currZero = zeroInput(table.current, SENSOR_FULL_SCALE) >> shift;
+    uint32_t decimation = SAMPLE_RATE / profile.rateHz;
+    uint32_t settlePairs = (uint64_t)STREAM_SETTLE * SAMPLE_RATE / 1000000;
+    uint32_t limit = (uint32_t)profile.durationS * profile.rateHz;
+
+    uint32_t stopsSeen = streamStops;
+    if (!streamer.start(
+        profile.start,
+        profile.step,
+        decimation > 0xFFFF ? 0xFFFF : decimation,
+        settlePairs,
+        voltZero,
+        currZero
+    )) {
+        calInUse.unlock();
+        return true;
+    }
+
+    enum StreamEnd reason = STREAM_RUNNING;
+    uint32_t unsent = 0;
+    uint16_t sinceStatus = 0;
+    StreamRecord record;
+    while (reason == STREAM_RUNNING) {
+        if (!streamer.collect(&record)) {
+            faults.raise(FAULT_ADC_STALL, profile.start);
+            reason = STREAM_STALLED;
+            break;
+        }
+        faults.checkIn(TASK_SWEEP);
+        CanFrame frame;
+        while (canLink.receive(&frame)) sensors.update(frame);
+        if (!emitStreamRecord(profile.mode, record, voltZero, currZero)) ++unsent;
+
+        if (++sinceStatus >= profile.rateHz) {
+            sinceStatus = 0;
+            emitStreamStatus(profile.mode, unsent, STREAM_RUNNING);
+        }
+        if (limit != 0 && streamer.getRecords() >= limit) reason = STREAM_COMPLETE;
+        if (streamStops != stopsSeen) reason = STREAM_STOPPED;
+    }
+    streamer.stop();
+    calInUse.unlock();
+    emitStreamStatus(profile.mode, unsent, reason);
+    return reason != STREAM_STALLED;
+}
+
+/** Figures of one output path of a link test. */
+struct LinkStats {
+    uint16_t records;
+    uint32_t bytes;             /* Committed to the link; CAN payload only. */
+    uint32_t elapsedUs;         /* From the first record until the link drained. */
+    uint16_t dropped;
+    uint16_t waits;             /* Records that found the link full. */
+    uint32_t cycles;            /* Spent encoding, every record. */
+};
+
+/**
+ * Synthetic point k of a link test: a smooth curve over 256 codes, 1 ms
+ * apart, so delta blocks compress about as those of a real sweep do.
+ */
+Point linkTestPoint(uint16_t k) {
+    uint16_t j = k & 0xFF;
+    Point point = {};
+    point.sampleId = k;
+    point.dacCode = 1024 + 4 * j;
+    point.volt = 4000 + 150 * j;
+    point.curr = 60000 - (uint16_t)((uint32_t)j * j * 7 / 8);
+    point.settleUs = 2000;
+    point.voltNoise = 3;
+    point.currNoise = 5;
+    point.mode = MODULE;
+    point.timeUs = (uint32_t)k * 1000;
+    return point;
+}
+
+/**
+ * Send the records of a link test down a serial path, encoded as the
+ * sweep output does, and time them until the link drains. A record the
+ * link has no room for in time means it stalled; the rest are dropped.
+ */
+LinkStats testSerialPath(enum LinkPath path, uint16_t records) {
+    LinkStats stats = {};
+    stats.records = records;
+    serialLink.drain();
+    uint32_t waitsSeen = serialLink.getWaits();
+    uint64_t since = DeviceClock::now();
+
+    Frame::DeltaEncoder encoder;
+    uint16_t k = 0;
+    for (; k < records; ++k) {
+        faults.checkIn(TASK_SWEEP);
+        Point point = linkTestPoint(k);
+        if (path == LINK_CSV) {
+            /* As emitPoint() prints it, formatted apart so only the formatting is timed. */
+            char line[LINK_TEST_LINE];
+            uint32_t start = StageStats::now();
+            CalPoint cal = calibrate(calStore.table(point.mode), point.dacCode, point.volt, point.curr);
+            int32_t power = (int64_t) cal.voltage * cal.current / 1000; // mW
+            int len = snprintf(
+                line,
+                sizeof(line),
+                "%f,%f,%f,%f,%lu,%u,%u,%u,%lu\n",
+                (float) cal.gate / 1000,
+                (float) cal.voltage / 1000,
+                (float) cal.current / 1000,
+                (float) power / 1000,
+                point.settleUs,
+                point.voltNoise,
+                point.currNoise,
+                point.channel,
+                point.timeUs
             );
+            stats.cycles += StageStats::now() - start;
+            if (len >= (int)sizeof(line)) len = sizeof(line) - 1;
+            if (serialLink.write(line, len) != len) break;
+            stats.bytes += len;
+        } else if (path == LINK_BINARY) {
+            uint8_t *frame = serialLink.reserve(Frame::POINT_SIZE);
+            if (frame == nullptr) break;
+            uint32_t start = StageStats::now();
+            uint32_t settleTicks = point.settleUs / Frame::SETTLE_UNIT_US;
+            Frame::encodePoint(
+                frame,
+                point.mode,
+                point.sampleId,
+                point.dacCode,
+                point.volt,
+                point.curr,
+                settleTicks > 0xFF ? 0xFF : settleTicks,
+                point.voltNoise,
+                point.currNoise,
+                point.timeUs,
+                point.channel
+            );
+            stats.cycles += StageStats::now() - start;
+            serialLink.commit(Frame::POINT_SIZE);
+            stats.bytes += Frame::POINT_SIZE;
+        } else {
+            /* A block per batch, as emitPointBlock() sends them. */
+            uint16_t inBlock = k % PointBatch::SIZE;
+            uint16_t count = records - (k - inBlock) < PointBatch::SIZE ? records - (k - inBlock) : PointBatch::SIZE;
+            if (inBlock == 0) {
+                uint8_t *block = serialLink.reserve(Frame::deltaMaxSize(count));
+                if (block == nullptr) break;
+                uint32_t start = StageStats::now();
+                encoder.begin(block, point.mode, point.sampleId);
+                stats.cycles += StageStats::now() - start;
+            }
+            uint32_t start = StageStats::now();
+            encoder.add(point.dacCode, point.volt, point.curr, point.timeUs);
+            uint16_t len = inBlock == count - 1 ? encoder.seal() : 0;
+            stats.cycles += StageStats::now() - start;
+            if (len != 0) {
+                serialLink.commit(len);
+                stats.bytes += len;
+            }
+        }
+    }
+    stats.dropped = records - k;
+    serialLink.drain();
+    stats.elapsedUs = (uint32_t)(DeviceClock::now() - since);
+    uint32_t waits = serialLink.getWaits() - waitsSeen;
+    stats.waits = waits > 0xFFFF ? 0xFFFF : waits;
+    return stats;
+}
+
+/**
+ * Wait a little for the CAN controller to take a frame.
+ *
+ * @return false It has taken none for LINK_TEST_STALL, e.g. with no
+ * other node on the bus to acknowledge.
+ */
+bool canProgress(uint32_t *sent, uint64_t *sinceUs) {
+    ThisThread::sleep_for(1ms);
+    faults.checkIn(TASK_SWEEP);
+    uint64_t now = DeviceClock::now();
+    if (canLink.getSent() != *sent) {
+        *sent = canLink.getSent();
+        *sinceUs = now;
+        return true;
+    }
+    return now - *sinceUs < LINK_TEST_STALL;
+}
+
+/**
+ * Send the records of a link test as CAN point frames and time them
+ * until the bus drains. A full queue is waited on rather than dropped, so
+ * the rate is that of the bus; records it never takes are dropped.
+ */
+LinkStats testCanPath(uint16_t records) {
+    LinkStats stats = {};
+    stats.records = records;
+    if (!canUp) {
+        stats.dropped = records;
+        return stats;
+    }
+    uint32_t sentBefore = canLink.getSent();
+    uint32_t sent = sentBefore;
+    uint64_t since = DeviceClock::now();
+    uint64_t progressUs = since;
+
+    for (uint16_t k = 0; k < records; ++k) {
+        faults.checkIn(TASK_SWEEP);
+        Point point = linkTestPoint(k);
+        uint8_t data[Frame::CAN_SIZE];
+        uint32_t start = StageStats::now();
+        Frame::encodeCanPoint(data, point.mode, point.sampleId, point.dacCode, point.volt, point.curr, point.channel);
+        stats.cycles += StageStats::now() - start;
+
+        bool posted = canLink.post(ID_POINT, data, Frame::CAN_SIZE);
+        if (!posted) {
+            ++stats.waits;
+            sent = canLink.getSent();
+            progressUs = DeviceClock::now();
         }
+        while (!posted && canProgress(&sent, &progressUs)) posted = canLink.post(ID_POINT, data, Frame::CAN_SIZE);
+        if (!posted) break;
+        stats.bytes += Frame::CAN_SIZE;
+    }
+    sent = canLink.getSent();
+    progressUs = DeviceClock::now();
+    while (!canLink.isIdle() && canProgress(&sent, &progressUs)) {}
+    stats.elapsedUs = (uint32_t)(DeviceClock::now() - since);
+
+    uint32_t delivered = canLink.getSent() - sentBefore;
+    stats.dropped = delivered >= records ? 0 : records - delivered;
+    return stats;
+}
+
+/** Send the figures of one output path of a link test. */
+void emitLinkStats(enum LinkPath path, const LinkStats &stats, uint32_t linkRate) {
+    uint32_t elapsedUs = stats.elapsedUs != 0 ? stats.elapsedUs : 1;
+    uint16_t delivered = stats.records - stats.dropped;
+    uint64_t bytesPerS = (uint64_t)stats.bytes * 1000000 / elapsedUs;
+    uint64_t recordsPerS = (uint64_t)delivered * 1000000 / elapsedUs;
+    uint32_t cyclesPerRecord = stats.cycles / (delivered != 0 ? delivered : 1);
+    if (__DEBUG_CSV__) {
+        printf(
+            "Link test %u at %lu: %u records, %lu bytes in %lu us, %lu B/s, %lu records/s, %u dropped, %u waited, %lu cycles/record\n",
+            path,
+            linkRate,
+            stats.records,
+            stats.bytes,
+            stats.elapsedUs,
+            (uint32_t)bytesPerS,
+            (uint32_t)recordsPerS,
+            stats.dropped,
+            stats.waits,
+            cyclesPerRecord
+        );
     } else {
-        printf("SCAN MODE\n");
-        printf("\n\nGate (V),Voltage (V),Current (A)\n");
-        ThisThread::sleep_for(10000ms);
+        uint8_t *frame = serialLink.reserve(Frame::LINK_STATS_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeLinkStats(
+            frame,
+            path,
+            stats.records,
+            stats.bytes,
+            stats.elapsedUs,
+            bytesPerS > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)bytesPerS,
+            recordsPerS > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)recordsPerS,
+            stats.dropped,
+            stats.waits,
+            cyclesPerRecord,
+            linkRate
+        );
+        serialLink.commit(Frame::LINK_STATS_SIZE);
+    }
+}
 
-        bool forward = true;
-        while (1) {
+/**
+ * Benchmark the output paths of a link test profile in turn, each ahead
+ * of its figures. The transmit thread is idle once drained, so the link
+ * and the CAN bus are ours meanwhile.
+ */
+void runLinkTest(const Profile &profile) {
+    pipeline.drain();
+    for (uint8_t p = 0; p < NUM_LINK_PATHS; ++p) {
+        if ((profile.testPaths & (1 << p)) == 0) continue;
+        enum LinkPath path = (enum LinkPath)p;
+        if (path == LINK_CAN) {
+            emitLinkStats(path, testCanPath(profile.testRecords), CAN_RATE);
+        } else {
+            emitLinkStats(path, testSerialPath(path, profile.testRecords), serialLink.getBaud());
+        }
+    }
+}
 
-            // [0.325, 0.4, 0.00025]: 25 iterations at 1 mS each.
-            if (forward) {
-                for (float i = 0.25; i <= 0.5; i += 0.001) {
-                    dacControl = i;
-                    float sVolt = 0.0;
-                    float sCurr = 0.0;
-
-                    for (uint8_t j = 0; j < ITERATIONS; ++j) {
-                        wait_us(SETTLING_TIME);
-                        sVolt += sensorVoltage.read();
-                        sCurr += sensorCurrent.read();
-                    }
-
-                    float dacVolt = calibrateDACOut(dacControl);
-                    sCurr = calibrateCurrentSensor(sCurr, ITERATIONS);
-                    sVolt = calibrateVoltageSensor(sVolt, sCurr, ITERATIONS, mode);
-                    printf(
-                        "%f,%f,%f,%f\n", 
-                        dacVolt, 
-                        sVolt,
-                        sCurr,
-                        sVolt * sCurr
-                    );
-                }
-                forward = false;
-            } else {
-                for (float i = 0.5; i >= 0.25; i -= 0.001) {
-                    dacControl = i;
-                    float sVolt = 0.0;
-                    float sCurr = 0.0;
-
-                    /* Capture the average of ITERATIONS reads. */
-                    for (uint8_t j = 0; j < ITERATIONS; ++j) {
-                        wait_us(SETTLING_TIME);
-                        sVolt += sensorVoltage.read();
-                        sCurr += sensorCurrent.read();
-                    }
-
-                    float dacVolt = calibrateDACOut(dacControl);
-                    sCurr = calibrateCurrentSensor(sCurr, ITERATIONS);
-                    sVolt = calibrateVoltageSensor(sVolt, sCurr, ITERATIONS, mode);
-                    printf(
-                        "%f,%f,%f,%f\n", 
-                        dacVolt, 
-                        sVolt,
-                        sCurr,
-                        sVolt * sCurr
-                    );
-                }
-                forward = true;
+/**
+ * Run one profile: its stream or link test, or its forward and reverse
+ * pass pairs back to back, from its compiled plan. A profile that cannot run at all is
+ * done with.
+ *
+ * @return false A fault cut it short.
+ */
+bool runProfile(const Profile &profile) {
+    if (profile.linkTest) {
+        runLinkTest(profile);
+        return true;
+    }
+    if (profile.stream) return runStream(profile);
+    const SweepPlan *plan = plans.find(profile);
+    if (plan == nullptr) return true;
+    mode = (enum Mode)plan->mode;
+    boardIo.shift = plan->blockShift;
+    boardIo.settleUs = plan->settleUs != 0 ? plan->settleUs : SETTLING_TIME;
+    boardIo.adaptive = __ADAPTIVE_SETTLE__;
+
+    /*
+     * Without a settle time from the host, tuning sweeps each pair at
+     * the regime's tuned time, fixed so the pair measures it.
+     */
+    bool tuned = __AUTO_SPEED__ && profile.settleUs == 0;
+    if (tuned) boardIo.adaptive = false;
+
+    /* The regime is fixed for a whole pass; dispatch once. */
+    for (uint16_t pass = 0; pass < 2 * profile.repeats; ++pass) {
+        bool forward = (pass & 1) == 0;
+        if (tuned && forward) boardIo.settleUs = tuners[mode].get();
+        switch (mode) {
+            case CELL:
+                runSweep<CELL>(plan->table, forward);
+                break;
+            case MODULE:
+                runSweep<MODULE>(plan->table, forward);
+                break;
+            case ARRAY:
+                runSweep<ARRAY>(plan->table, forward);
+                break;
+            default:
+                emitException(ID_FAULT, FAULT_BAD_REGIME, mode);
+                return true;
+        }
+        if (faults.isPending()) return false;
+    }
+    return true;
+}
+
+/**
+ * Sweep thread: take the queued profiles in turn and run them. A profile
+ * cut short by a fault is run again once acquisition is back, up to
+ * FAULT_RETRIES times. Completion is reported in stream order by the
+ * transmit thread; the sweep never waits on the host.
+ */
+void performTest(void) {
+    Profile profile;
+    bool repeatable = false;
+    while (1) {
+        if (!nextProfile(&profile, repeatable)) continue;
+        repeatable = true;
+        faults.busy(TASK_SWEEP);
+        uint8_t attempts = 0;
+        while (!runProfile(profile)) {
+            recoverFromFault();
+            if (++attempts == FAULT_RETRIES) {
+                emitException(ID_FAULT, FAULT_PROFILE_DROPPED, profile.id);
+                break;
             }
         }
+        faults.idle(TASK_SWEEP);
+        pipeline.finish(profile.id);
     }
 }
 
+/**
+ * Main thread: report rejected requests and serve readouts, timing
+ * requests and calibration commits, after the RX ISR has flagged them.
+ */
+void serveRequests(void) {
+    static uint32_t rejectsSeen = 0;
+    static uint32_t readoutsSeen = 0;
+    static uint32_t timingsSeen = 0;
+    static uint32_t calCommitsSeen = 0;
+    static uint32_t calRejectsSeen = 0;
+
+    /* Time sync first; the reply time is all the host sees of the delay. */
+    TimeSync sync;
+    while (serialSyncs.pop(&sync)) emitTimeSync(Frame::SYNC_SERIAL, sync);
+    while (canSyncs.pop(&sync)) {
+        uint8_t data[Frame::CAN_SIZE];
+        Frame::encodeCanTimeSyncReply(data, sync.sequence, sync.receivedUs);
+        canLink.post(ID_TIME_SYNC_REPLY, data, Frame::CAN_SIZE);
+        emitTimeSync(Frame::SYNC_CAN, sync);
+    }
+
+    if (profileRejects != rejectsSeen) {
+        /* A burst of rejects must not mix the fields of two frames. */
+        core_util_critical_section_enter();
+        rejectsSeen = profileRejects;
+        uint16_t msgId = profileRejectId;
+        uint8_t status = profileStatus;
+        uint16_t count = profileCount;
+        core_util_critical_section_exit();
+        emitException(msgId, status, count);
+    }
+    if (readoutRequests != readoutsSeen) {
+        /* The RX ISR writes the pair; a later request must not split it. */
+        core_util_critical_section_enter();
+        readoutsSeen = readoutRequests;
+        uint8_t status = readoutStatus;
+        uint16_t sweepId = readoutSweep;
+        core_util_critical_section_exit();
+        if (status == READOUT_OK) {
+            emitReadout(sweepId);
+        } else {
+            emitException(ID_READOUT, status, 0);
+        }
+    }
+    if (timingRequests != timingsSeen) {
+        timingsSeen = timingRequests;
+        timingLock.lock();
+        StageStats stats = lastTiming;
+        uint16_t sweepId = lastTimingSweep;
+        timingLock.unlock();
+        emitTiming(sweepId, stats);
+    }
+    if (calRejects != calRejectsSeen) {
+        calRejectsSeen = calRejects;
+        emitException(calRejectId, calStatus, calOffset);
+    }
+    if (calCommits != calCommitsSeen) {
+        calCommitsSeen = calCommits;
+        enum CalStatus status = CAL_BUSY;
+        if (calInUse.trylock()) {
+            status = calStore.commit();
+            calInUse.unlock();
+        }
+        if (status == CAL_OK) {
+            emitCalStatus();
+        } else {
+            emitException(ID_CAL_COMMIT, status, 0);
+        }
+    }
+}
 
+/** Send the reading of a reference load. */
+void emitCalReading(const Point &point, uint16_t readings) {
+    if (__DEBUG_CSV__) {
+        printf(
+            "Reference @ %u: V %u, I %u (codes/16), noise %u, %u, %u readings\n",
+            point.dacCode,
+            point.volt,
+            point.curr,
+            point.voltNoise,
+            point.currNoise,
+            readings
+        );
+    } else {
+        uint8_t *frame = serialLink.reserve(Frame::CAL_READING_SIZE);
+        if (frame == nullptr) return;
+        Frame::encodeCalReading(
+            frame,
+            point.mode,
+            point.dacCode,
+            point.volt,
+            point.curr,
+            point.voltNoise,
+            point.currNoise,
+            readings
+        );
+        serialLink.commit(Frame::CAL_READING_SIZE);
+    }
+}
+
+/**
+ * Measure a reference load CAL_READINGS times at its DAC code, with the
+ * sweep engine at its longest averaging, and add each reading to the
+ * fits of its regime. A fault drops the reading it hit and the rest; the
+ * host sees the reading count fall short and sends the reference again.
+ */
+void measureReference(const CalReference &reference) {
+    mode = (enum Mode)reference.mode;
+    LinearFit *fits = calFits[reference.mode];
+
+    /* The voltage sensor sees the terminal voltage less the PCB drop. */
+    const CalTable &table = calStore.table(reference.mode);
+    int32_t drop = (int32_t)(((int64_t)reference.currMa * table.seriesDrop) >> 16);
+
+    Point point = {};
+    for (uint8_t k = 0; k < CAL_READINGS; ++k) {
+        point = measureAt(reference.dacCode);
+        if (faults.isPending()) {
+            recoverFromFault();
+            break;
+        }
+        fits[CAL_VOLTAGE].add(point.volt, (int32_t)reference.voltMv - drop);
+        fits[CAL_CURRENT].add(point.curr, (int32_t)reference.currMa);
+        if (reference.gateMv != Frame::GATE_NOT_MEASURED) {
+            fits[CAL_DAC].add(point.dacCode, reference.gateMv);
+        }
+    }
+    emitCalReading(point, fits[CAL_VOLTAGE].count());
+}
+
+/**
+ * Fit every term with readings of at least two distinct inputs, keep the
+ * others, and write the result to the store.
+ */
+void fitCalibration(uint16_t revision) {
+    CalTable tables[NUM_MODES];
+    bool fitted = false;
+    for (uint8_t m = 0; m < NUM_MODES; ++m) {
+        tables[m] = calStore.table(m);
+        for (uint8_t t = 0; t < NUM_CAL_TERMS; ++t) {
+            uint32_t rms;
+            CalTerm &term = termAt(tables[m], t);
+            if (!calFits[m][t].solve(&term, &rms)) continue;
+            fitted = true;
+            if (__DEBUG_CSV__) {
+                printf("Fit %u.%u: gain %ld, offset %ld, RMS residual %lu\n", m, t, term.gain, term.offset, rms);
+            }
+        }
+    }
+    if (!fitted) {
+        emitException(ID_CAL_FIT, CAL_TOO_FEW_READINGS, 0);
+        return;
+    }
+
+    enum CalStatus status = calStore.save(tables, revision != 0 ? revision : calStore.getRevision() + 1);
+    if (status != CAL_OK) {
+        emitException(ID_CAL_FIT, status, 0);
+        return;
+    }
+    for (uint8_t m = 0; m < NUM_MODES; ++m) {
+        for (uint8_t t = 0; t < NUM_CAL_TERMS; ++t) calFits[m][t].reset();
+    }
+    emitCalStatus();
+}
+
+/** Report what went wrong before the host was listening. */
+void emitBootFaults(bool watchdogUp) {
+    if (FaultMonitor::wasWatchdogReset()) emitException(ID_FAULT, FAULT_WATCHDOG_RESET, 0);
+    if (!watchdogUp) emitException(ID_FAULT, FAULT_WATCHDOG_START, 0);
+    if (!canUp) emitException(ID_FAULT, FAULT_CAN_START, 0);
+}
+
+int main() {
+    tickHeartbeat.attach(&heartbeat, 500ms);
+    StageStats::enableCounter();
+    calStore.load();
+    for (uint8_t m = 0; m < NUM_MODES; ++m) tuners[m].reset(SETTLING_TIME);
+    dacControl = 0.0; // 1.0 for open circuit, 0.0 for short circuit
+#if NUM_CHANNELS > 1
+    dacControl1 = 0.0;
+#endif
+    bool watchdogUp = faults.start();
+    if (!adc.start(SAMPLE_RATE, OVERSAMPLING)) resetOnFault(FAULT_ADC_RESTART, 0);
+    if (canLink.start(CAN_RATE)) {
+        canLink.attachClock(callback(&adc, &AdcDma::getBlockCount));
+        canLink.attachSync(ID_TIME_SYNC, onCanSync);
+        canUp = canLink.accept(CAN_IDS, sizeof(CAN_IDS) / sizeof(CAN_IDS[0]));
+    }
+
+    if (__DEBUG_TUNING__) {
+        printf("CALIBRATION MODE\n");
+        if (!__DEBUG_CSV__) serialLink.negotiate(LINK_RATES, sizeof(LINK_RATES) / sizeof(LINK_RATES[0]));
+        emitCalStatus();
+        emitBootFaults(watchdogUp);
+        boardIo.shift = MAX_BLOCK_SHIFT;
+
+        /* References are measured as they come; the host sends the fit request last. */
+        serialLink.attach(onFrame);
+        uint32_t fitsSeen = 0;
+        while (1) {
+            hostEvents.wait_any(HOST_REQUEST);
+            serveRequests();
+            CalReference reference;
+            while (calReferences.pop(&reference)) measureReference(reference);
+            if (calFitRequests != fitsSeen) {
+                fitsSeen = calFitRequests;
+                fitCalibration(calFitRevision);
+            }
+        }
+    } else {
+        printf("SCAN MODE\n");
+        if (__DEBUG_CSV__) {
+            printf("\n\nGate (V),Voltage (V),Current (A),Power (W),Settle (us),V Noise (codes/16),I Noise (codes/16),Channel,Time (us)\n");
+        } else {
+            serialLink.negotiate(LINK_RATES, sizeof(LINK_RATES) / sizeof(LINK_RATES[0]));
+        }
+        emitCalStatus();
+        emitBootFaults(watchdogUp);
+
+        /* Start threads for output message processing and profile testing. */
+        threadProcessing.start(transmitResults);
+        threadTesting.start(performTest);
+
+        /*
+         * Requests are parsed in the RX ISR; the main thread reports
+         * rejects and serves readouts.
+         */
+        serialLink.attach(onFrame);
+        idle.attach(callback(&serialLink, &SerialLink::resume));
+        while (1) {
+            hostEvents.wait_any(HOST_REQUEST);
+            serveRequests();
+        }
+    }
+}
\ No newline at end of file